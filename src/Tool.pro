@@ -17,11 +17,14 @@ CONFIG += release
 CONFIG -= app_bundle
 CONFIG -= qt
 
-HEADERS += mdp.hpp
+HEADERS += mdp.hpp valueIteration.hpp memoryMappedFile.hpp graphAnalysis.hpp singlePrecisionValueIteration.hpp statistics.hpp server.hpp batch.hpp distributedValueIteration.hpp
 
-SOURCES += main.cpp mdp.cpp computePolicy.cpp
+SOURCES += main.cpp mdp.cpp computePolicy.cpp memoryMappedFile.cpp binaryMDPFile.cpp singlePrecisionValueIteration.cpp bisimulation.cpp strategy.cpp statistics.cpp mdpBuilder.cpp policySearch.cpp incrementalSolving.cpp server.cpp batch.cpp
 
 TARGET = ramps
+# The benchmark program "rampsBenchmark" is built by "benchmark/Benchmark.pro" from the same sources,
+# and the library "libramps" by "library/Library.pro".
+# For distributed value iteration, the sources are compiled with an MPI compiler and "-DUSE_MPI" (see README.md).
 INCLUDEPATH =
 
 LIBS +=
@@ -0,0 +1,189 @@
+#include "batch.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <set>
+#include <algorithm>
+#include <new>
+#include <exception>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//=====================================================
+// Batch mode
+//
+// The MDP is read once, and the specifications are
+// processed in parallel, each with its own product,
+// value iteration cache, and share of the threads.
+// The messages of the policy search for every
+// specification are collected and written at once
+// when it is done, so that the messages of different
+// specifications are not mixed up.
+//=====================================================
+
+namespace {
+
+/**
+ * @brief Computes the name of the strategy file for a parity automaton file
+ */
+std::string getStrategyFilename(const std::string &parityFilename, const std::string &outputDirectory) {
+    std::string base = parityFilename;
+    if ((base.size()>7) && (base.compare(base.size()-7,7,".parity")==0)) base = base.substr(0,base.size()-7);
+    if (outputDirectory!="") {
+        const size_t slash = base.rfind('/');
+        if (slash!=std::string::npos) base = base.substr(slash+1);
+        base = outputDirectory+"/"+base;
+    }
+    return base+".strategy";
+}
+
+/**
+ * @brief Computes the policy for one parity automaton and writes it to a file
+ * @param log Receives the messages of the policy search
+ * @return The quality of the policy
+ */
+double solveSpecification(const MDP &mdp, const std::string &parityFilename, const std::string &strategyFilename, const BatchSettings &settings, std::ostream &log) {
+    const ParityAutomaton automaton(parityFilename);
+    std::unique_ptr<MDP> quotientMDP;
+    BisimulationQuotientMapping quotientMapping;
+    if (settings.bisimulation) {
+        std::vector<bool> relevantComponents;
+        std::vector<bool> relevantActions;
+        ParityMDP::findReferencedLabels(automaton,mdp,relevantComponents,relevantActions);
+        quotientMDP.reset(new MDP(mdp,relevantComponents,relevantActions,quotientMapping));
+        log << "Bisimulation quotient: " << quotientMDP->nofStates() << " of " << mdp.nofStates() << " states.\n";
+    }
+    const ParityMDP parityMDP(automaton,settings.bisimulation?*quotientMDP:mdp);
+    ValueIterationCache valueIterationCache(settings.valueIterationCacheSize);
+    const std::pair<Strategy,double> bestStrategy = parityMDP.searchRAPolicy(settings.policySearchSettings,(settings.valueIterationCacheSize>0)?&valueIterationCache:NULL,NULL,&log);
+
+    std::ofstream outFile(strategyFilename);
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Cannot open strategy file '" << strategyFilename << "' for writing.";
+        throw error.str();
+    }
+    if (settings.bisimulation) {
+        std::vector<unsigned int> mdpStates;
+        const Strategy mappedStrategy = parityMDP.mapPolicyToOriginalMDP(bestStrategy.first,mdp,quotientMapping,mdpStates);
+        mappedStrategy.writeText(outFile,mdpStates);
+    } else {
+        bestStrategy.first.writeText(outFile,parityMDP.mdpStates());
+    }
+    outFile.close();
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Error writing strategy file '" << strategyFilename << "'.";
+        throw error.str();
+    }
+    return bestStrategy.second;
+}
+
+}
+
+/**
+ * @brief Collects the parity automaton files to process. Directories are replaced by the ".parity" files in them
+ *        (in the order of their names), and files are taken as they are.
+ * @param paths The files and directories
+ * @return The parity automaton files
+ */
+std::vector<std::string> findParityFiles(const std::vector<std::string> &paths) {
+    std::vector<std::string> parityFilenames;
+    for (const std::string &path : paths) {
+        struct stat fileStatus;
+        if ((stat(path.c_str(),&fileStatus)==0) && S_ISDIR(fileStatus.st_mode)) {
+            DIR *directory = opendir(path.c_str());
+            if (directory==NULL) {
+                std::ostringstream error;
+                error << "Cannot read the directory '" << path << "'.";
+                throw error.str();
+            }
+            std::vector<std::string> names;
+            while (struct dirent *entry = readdir(directory)) {
+                const std::string name = entry->d_name;
+                if ((name.size()>7) && (name.compare(name.size()-7,7,".parity")==0)) names.push_back(name);
+            }
+            closedir(directory);
+            std::sort(names.begin(),names.end());
+            for (const std::string &name : names) parityFilenames.push_back(path+"/"+name);
+        } else {
+            parityFilenames.push_back(path);
+        }
+    }
+    return parityFilenames;
+}
+
+/**
+ * @brief Computes a policy for every parity automaton and writes it to a strategy file with the name of the parity
+ *        automaton file, but with the suffix ".strategy" instead of ".parity". Errors for one parity automaton are
+ *        reported, but do not stop the processing of the others.
+ * @param mdp The MDP
+ * @param parityFilenames The parity automaton files
+ * @param settings The search settings and the degree of parallelism
+ * @return Whether policies could be computed for all parity automata
+ */
+bool solveBatch(const MDP &mdp, const std::vector<std::string> &parityFilenames, const BatchSettings &settings) {
+    if (settings.nofParallelSpecifications==0) throw "Error: The number of parallel specifications must be positive.";
+    const unsigned int nofSpecifications = parityFilenames.size();
+    std::vector<std::string> strategyFilenames;
+    std::set<std::string> usedStrategyFilenames;
+    for (const std::string &parityFilename : parityFilenames) {
+        strategyFilenames.push_back(getStrategyFilename(parityFilename,settings.outputDirectory));
+        if (!usedStrategyFilenames.insert(strategyFilenames.back()).second) {
+            std::ostringstream error;
+            error << "Error: Two specifications would be written to the same strategy file '" << strategyFilenames.back() << "'.";
+            throw error.str();
+        }
+    }
+
+    const unsigned int nofParallelSpecifications = std::max(1u,std::min(settings.nofParallelSpecifications,nofSpecifications));
+#ifdef _OPENMP
+    const int nofThreadsPerSpecification = std::max(1,omp_get_max_threads()/(int)nofParallelSpecifications);
+    omp_set_max_active_levels(std::max(omp_get_max_active_levels(),3));
+#endif
+    unsigned int nofFailures = 0;
+    #pragma omp parallel for schedule(dynamic,1) num_threads(nofParallelSpecifications) reduction(+:nofFailures)
+    for (unsigned int i=0;i<nofSpecifications;i++) {
+#ifdef _OPENMP
+        omp_set_num_threads(nofThreadsPerSpecification);
+#endif
+        std::ostringstream log;
+        std::string error = "";
+        double quality = 0.0;
+        // Exceptions must not leave the parallel region
+        try {
+            quality = solveSpecification(mdp,parityFilenames[i],strategyFilenames[i],settings,log);
+        } catch (int code) {
+            std::ostringstream message;
+            message << "Numerical error " << code;
+            error = message.str();
+        } catch (const char *message) {
+            error = message;
+        } catch (const std::string message) {
+            error = message;
+        } catch (const std::bad_alloc &) {
+            error = "Out of memory.";
+        } catch (const std::exception &exception) {
+            error = exception.what();
+        } catch (...) {
+            error = "Unknown error.";
+        }
+        #pragma omp critical
+        {
+            std::cerr << "=== " << parityFilenames[i] << "\n" << log.str();
+            if (error=="") {
+                std::cerr << "Quality of the generated strategy: " << quality << ", written to " << strategyFilenames[i] << std::endl;
+            } else {
+                if (error.compare(0,7,"Error: ")==0) error = error.substr(7);
+                std::cerr << "Error: " << error << std::endl;
+            }
+        }
+        if (error!="") nofFailures++;
+    }
+    if (nofFailures>0) std::cerr << "Failed for " << nofFailures << " of " << nofSpecifications << " specifications.\n";
+    return nofFailures==0;
+}
@@ -0,0 +1,23 @@
+#ifndef __BATCH_HPP____
+#define __BATCH_HPP____
+
+#include <string>
+#include <vector>
+#include "mdp.hpp"
+
+/**
+ * @brief Parameters of the batch mode, in which policies for several parity automata are computed for the same MDP
+ */
+struct BatchSettings {
+    PolicySearchSettings policySearchSettings;
+    bool bisimulation;
+    unsigned int valueIterationCacheSize; // in MB, per parity automaton
+    unsigned int nofParallelSpecifications;
+    std::string outputDirectory; // If empty, the strategies are written next to the parity automaton files
+    BatchSettings() : bisimulation(false), valueIterationCacheSize(1024), nofParallelSpecifications(4) {}
+};
+
+std::vector<std::string> findParityFiles(const std::vector<std::string> &paths);
+bool solveBatch(const MDP &mdp, const std::vector<std::string> &parityFilenames, const BatchSettings &settings);
+
+#endif
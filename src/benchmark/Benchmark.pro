@@ -0,0 +1,31 @@
+# QMake Build file for the benchmark program. It uses the same sources as
+# "../Tool.pro", except for the main function of RAMPS.
+QMAKE_CC = gcc
+QMAKE_LINK_C = gcc
+QMAKE_CXX = g++
+QMAKE_LINK = g++
+DEFINES += # No NDEBUG here.
+CFLAGS += -g -fpermissive
+
+QMAKE_CFLAGS_RELEASE += -g -march=native -fopenmp
+QMAKE_CXXFLAGS_RELEASE += -g -std=c++11  -march=native -fopenmp
+QMAKE_CFLAGS_DEBUG += -g -Wall -Wextra  -march=native -fopenmp
+QMAKE_CXXFLAGS_DEBUG += -g -std=c++11 -Wall -Wextra  -march=native -fopenmp
+QMAKE_LFLAGS += -fopenmp
+
+TEMPLATE = app console
+CONFIG += release
+CONFIG -= app_bundle
+CONFIG -= qt
+
+HEADERS += modelGenerator.hpp ../mdp.hpp ../valueIteration.hpp ../memoryMappedFile.hpp ../graphAnalysis.hpp ../singlePrecisionValueIteration.hpp ../statistics.hpp ../distributedValueIteration.hpp
+
+SOURCES += benchmark.cpp modelGenerator.cpp ../mdp.cpp ../computePolicy.cpp ../memoryMappedFile.cpp ../binaryMDPFile.cpp ../singlePrecisionValueIteration.cpp ../bisimulation.cpp ../strategy.cpp ../statistics.cpp ../mdpBuilder.cpp ../policySearch.cpp ../incrementalSolving.cpp
+
+TARGET = rampsBenchmark
+INCLUDEPATH =
+
+LIBS +=
+
+PKGCONFIG += 
+QT -= gui core
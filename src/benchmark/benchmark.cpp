@@ -0,0 +1,284 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <sys/resource.h>
+#include "../mdp.hpp"
+#include "modelGenerator.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//=====================================================
+// Benchmark for RAMPS
+//
+// Generates a model (or takes an existing one) and
+// times the phases of RAMPS separately: parsing the
+// PRISM files, building the product with the parity
+// automaton, a value iteration call on the MDP, and a
+// binary search for the best RA policy (as with the
+// default search strategy of RAMPS). This is repeated
+// for every requested number of threads.
+//=====================================================
+
+namespace {
+
+/**
+ * @brief The measurements of one phase for one number of threads
+ */
+struct PhaseResult {
+    std::string phase;
+    unsigned int nofStates;
+    uint64_t nofEdges;
+    std::vector<double> seconds; // One per repetition
+    long peakRSSInKB; // The highest one over all repetitions
+    PhaseResult() : nofStates(0), nofEdges(0), peakRSSInKB(-1) {}
+};
+
+double getMedian(std::vector<double> values) {
+    std::sort(values.begin(),values.end());
+    if (values.size()%2==1) return values[values.size()/2];
+    return (values[values.size()/2-1]+values[values.size()/2])/2;
+}
+
+/**
+ * @brief Resets the peak resident memory of the process to its current resident memory, so that the peak of the
+ *        next phase can be measured. This needs the Linux "/proc" file system.
+ * @return true if the peak has been reset
+ */
+bool resetPeakRSS() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+}
+
+/**
+ * @brief Reads the peak resident memory of the process since the last call of "resetPeakRSS" ("VmHWM"). Without
+ *        the Linux "/proc" file system, the peak since the start of the process is returned instead.
+ */
+long getPeakRSSInKB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status,line)) {
+        if (line.compare(0,6,"VmHWM:")==0) {
+            std::istringstream is(line.substr(6));
+            long peakInKB;
+            if (is >> peakInKB) return peakInKB;
+        }
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF,&usage)!=0) return -1;
+    return usage.ru_maxrss;
+}
+
+template<class Function> double measureSeconds(const Function &function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+ * @brief Performs a binary search for the best RA level, like the search strategy "b:<cutoff>:<epsilon>" of RAMPS
+ * @return The RA level of the best policy found
+ */
+double searchRAPolicy(const ParityMDP &parityMDP, double cutoff, double epsilon) {
+    PolicySearchSettings settings;
+    settings.searchStrategy.assign(1,SearchStrategyPart('b',cutoff,epsilon));
+    ValueIterationCache cache(1024);
+    return parityMDP.searchRAPolicy(settings,&cache).second;
+}
+
+/**
+ * @brief Runs all phases once and adds the running times to the results (in the order parse, product,
+ *        valueIteration, computeRAPolicy)
+ */
+void runPhases(const std::string &baseFilename, double cutoff, double epsilon, std::vector<PhaseResult> &results, double &raLevel) {
+    auto record = [&results](unsigned int phase, double seconds, unsigned int nofStates, uint64_t nofEdges) {
+        results[phase].seconds.push_back(seconds);
+        results[phase].nofStates = nofStates;
+        results[phase].nofEdges = nofEdges;
+        results[phase].peakRSSInKB = std::max(results[phase].peakRSSInKB,getPeakRSSInKB());
+        resetPeakRSS();
+    };
+
+    resetPeakRSS();
+    MDP mdp;
+    double seconds = measureSeconds([&]() { mdp = MDP(baseFilename); });
+    record(0,seconds,mdp.nofStates(),mdp.transitions.targets.size());
+
+    std::unique_ptr<ParityMDP> parityMDP;
+    seconds = measureSeconds([&]() { parityMDP.reset(new ParityMDP(baseFilename+".parity",mdp)); });
+    record(1,seconds,parityMDP->nofStates(),parityMDP->nofEdges());
+
+    // Value iteration on the MDP towards region B (or the states whose last label component has the value "1"
+    // if there is no such component), avoiding the error states
+    FixedValues fixedValues(mdp.nofStates());
+    int goalComponent = (int)mdp.labelComponents.size()-1;
+    int errorComponent = -1;
+    for (unsigned int c=0;c<mdp.labelComponents.size();c++) {
+        if (mdp.labelComponents[c]=="regionB") goalComponent = c;
+        if (mdp.labelComponents[c]=="error") errorComponent = c;
+    }
+    for (unsigned int i=0;i<mdp.nofStates();i++) {
+        if ((goalComponent>=0) && (mdp.labels.value(i,goalComponent)=="1")) {
+            fixedValues.set(i,1.0);
+        } else if ((errorComponent>=0) && (mdp.labels.value(i,errorComponent)=="1")) {
+            fixedValues.set(i,0.0);
+        }
+    }
+    ValueIterationSettings settings;
+    settings.epsilon = epsilon;
+    seconds = measureSeconds([&]() { mdp.valueIteration(fixedValues,settings); });
+    record(2,seconds,mdp.nofStates(),mdp.transitions.targets.size());
+
+    seconds = measureSeconds([&]() { raLevel = searchRAPolicy(*parityMDP,cutoff,epsilon); });
+    record(3,seconds,parityMDP->nofStates(),parityMDP->nofEdges());
+}
+
+/**
+ * @brief Parses a comma-separated list of positive numbers
+ */
+std::vector<unsigned int> parseNumberList(const std::string &text) {
+    std::vector<unsigned int> numbers;
+    std::istringstream is(text);
+    std::string part;
+    while (std::getline(is,part,',')) {
+        std::istringstream partStream(part);
+        unsigned int number;
+        partStream >> number;
+        if (partStream.fail() || !partStream.eof() || (number==0)) throw "Error: Illegal list of numbers.";
+        numbers.push_back(number);
+    }
+    if (numbers.empty()) throw "Error: Illegal list of numbers.";
+    return numbers;
+}
+
+}
+
+int main(int nofArgs, const char **args) {
+
+    try {
+
+        // Parse parameters
+        std::string familyName = "grid";
+        unsigned int size = 100;
+        uint64_t seed = 1;
+        std::string baseFilename = "";
+        std::string modelFilename = "";
+        bool generateOnly = false;
+        unsigned int nofRepetitions = 1;
+        double cutoff = 0.01;
+        double epsilon = 0.05;
+        std::vector<unsigned int> threadCounts;
+#ifdef _OPENMP
+        threadCounts.push_back(omp_get_max_threads());
+#else
+        threadCounts.push_back(1);
+#endif
+
+        for (int i=1;i<nofArgs;i++) {
+            std::string param = args[i];
+            if (param=="--generateOnly") {
+                generateOnly = true;
+                continue;
+            }
+            if (nofArgs<=i+1) {
+                std::cerr << "Error: No parameter after '" << param << "'.\n";
+                return 1;
+            }
+            const std::string value = args[++i];
+            std::istringstream is(value);
+            if (param=="--family") {
+                familyName = value;
+            } else if (param=="--size") {
+                is >> size;
+            } else if (param=="--seed") {
+                is >> seed;
+            } else if (param=="--output") {
+                baseFilename = value;
+            } else if (param=="--model") {
+                modelFilename = value;
+            } else if (param=="--threads") {
+                threadCounts = parseNumberList(value);
+            } else if (param=="--repetitions") {
+                is >> nofRepetitions;
+            } else if (param=="--cutoff") {
+                is >> cutoff;
+            } else if (param=="--epsilon") {
+                is >> epsilon;
+            } else {
+                std::cerr << "Error: Did not understand parameter " << param << std::endl;
+                return 1;
+            }
+            if (is.fail() || (nofRepetitions==0)) {
+                std::cerr << "Error: Illegal value after '" << param << "'.\n";
+                return 1;
+            }
+        }
+
+        // Generate the model
+        if (modelFilename=="") {
+            const ModelFamily family = parseModelFamily(familyName);
+            if (baseFilename=="") {
+                std::ostringstream name;
+                name << familyName << "_" << size << "_" << seed;
+                baseFilename = name.str();
+            }
+            GeneratedModel model;
+            const double seconds = measureSeconds([&]() {
+                model = generateModel(family,size,seed);
+                writeModelFiles(model,baseFilename);
+            });
+            std::cerr << "Generated " << baseFilename << " with " << model.nofStates() << " states and " << model.transitions.targets.size() << " edges in " << seconds << " s.\n";
+            if (generateOnly) return 0;
+        } else {
+            if (generateOnly) {
+                std::cerr << "Error: '--generateOnly' cannot be combined with '--model'.\n";
+                return 1;
+            }
+            baseFilename = modelFilename;
+        }
+
+        // Measure. If the peak resident memory cannot be reset, the column has the peak of the process so far.
+        const bool peakRSSPerPhase = resetPeakRSS();
+        std::cout << "model\tthreads\tphase\tstates\tedges\tseconds\tstates/s\tedges/s\t" << (peakRSSPerPhase?"phasePeakRSS(MB)":"peakRSSSoFar(MB)") << "\n";
+        for (unsigned int nofThreads : threadCounts) {
+#ifdef _OPENMP
+            omp_set_num_threads(nofThreads);
+#else
+            if (nofThreads!=1) std::cerr << "Warning: Compiled without OpenMP, so only one thread is used.\n";
+#endif
+            std::vector<PhaseResult> results(4);
+            results[0].phase = "parse";
+            results[1].phase = "product";
+            results[2].phase = "valueIteration";
+            results[3].phase = "computeRAPolicy";
+            double raLevel = 0.0;
+            for (unsigned int r=0;r<nofRepetitions;r++) {
+                runPhases(baseFilename,cutoff,epsilon,results,raLevel);
+            }
+            for (auto &result : results) {
+                const double seconds = getMedian(result.seconds);
+                std::cout << baseFilename << "\t" << nofThreads << "\t" << result.phase << "\t" << result.nofStates << "\t" << result.nofEdges << "\t"
+                          << std::setprecision(4) << seconds << "\t" << std::setprecision(4) << result.nofStates/seconds << "\t" << result.nofEdges/seconds << "\t"
+                          << result.peakRSSInKB/1024 << "\n";
+            }
+            std::cerr << "RA level found with " << nofThreads << " threads: " << raLevel << std::endl;
+        }
+
+    } catch (int error) {
+        std::cerr << "Numerical error " << error << std::endl;
+        return 1;
+    } catch (const char *error) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    } catch (const std::string error) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+}
@@ -0,0 +1,274 @@
+#include "modelGenerator.hpp"
+#include <random>
+#include <map>
+#include <cstdio>
+#include <sstream>
+
+//=====================================================
+// Model generator for the benchmarks
+//
+// All families label their states with "regionA",
+// "regionB", and "error", so that the same parity
+// automaton can be used for all of them:
+//
+// - State 0 (color 1) waits for region A,
+// - state 1 (color 1) waits for region B,
+// - state 2 (color 2) is visited right after region B,
+// - state 3 (color 3) is visited in error states.
+//
+// Error states are never in region A or B, so that the
+// guards of every automaton state are disjoint.
+//=====================================================
+
+namespace {
+
+/**
+ * @brief Adds a choice whose edges are given as a map from target states to probabilities.
+ */
+void addChoice(GeneratedModel &model, int action, const std::map<unsigned int,double> &edges) {
+    model.transitions.addChoice(action);
+    for (auto &edge : edges) model.transitions.addEdge(edge.second,edge.first);
+}
+
+/**
+ * @brief Grid world: The robot moves in the four directions, and with probability 0.1 each, it moves to one of
+ *        the two neighboring directions instead. Moves beyond the border of the grid keep the robot in its cell.
+ *        Region A is the top left corner, region B the bottom right corner, and 10% of the other cells are error
+ *        cells.
+ */
+GeneratedModel generateGridModel(unsigned int size, std::mt19937_64 &rng) {
+    GeneratedModel model;
+    model.labelComponents = {"xpos","ypos","regionA","regionB","error"};
+    model.actions = {"n","e","s","w"};
+    const unsigned int regionSize = std::max(1u,size/8);
+    std::bernoulli_distribution errorCell(0.1);
+    for (unsigned int y=0;y<size;y++) {
+        for (unsigned int x=0;x<size;x++) {
+            const bool regionA = (x<regionSize) && (y<regionSize);
+            const bool regionB = (x+regionSize>=size) && (y+regionSize>=size);
+            const bool error = errorCell(rng) && !regionA && !regionB;
+            model.labels.push_back({x,y,regionA,regionB,error});
+        }
+    }
+    const int dx[4] = {0,1,0,-1};
+    const int dy[4] = {-1,0,1,0};
+    auto move = [&](unsigned int x, unsigned int y, unsigned int direction) {
+        const int newX = (int)x+dx[direction];
+        const int newY = (int)y+dy[direction];
+        if ((newX<0) || (newY<0) || (newX>=(int)size) || (newY>=(int)size)) return y*size+x;
+        return (unsigned int)(newY*size+newX);
+    };
+    for (unsigned int y=0;y<size;y++) {
+        for (unsigned int x=0;x<size;x++) {
+            model.transitions.addState();
+            for (unsigned int direction=0;direction<4;direction++) {
+                std::map<unsigned int,double> edges;
+                edges[move(x,y,direction)] += 0.8;
+                edges[move(x,y,(direction+1)%4)] += 0.1;
+                edges[move(x,y,(direction+3)%4)] += 0.1;
+                addChoice(model,direction,edges);
+            }
+        }
+    }
+    return model;
+}
+
+/**
+ * @brief Random sparse MDP: Every state has 2 to 4 choices with 2 to 8 edges each, to random targets. The first
+ *        edge of the first choice of every state leads to the next state, so that all states are reachable from
+ *        state 0. About 1% of the states are in region A, 1% in region B, and 5% are error states.
+ */
+GeneratedModel generateRandomModel(unsigned int size, std::mt19937_64 &rng) {
+    GeneratedModel model;
+    model.labelComponents = {"regionA","regionB","error"};
+    model.actions = {"a0","a1","a2","a3"};
+    std::uniform_real_distribution<double> uniform(0.0,1.0);
+    std::uniform_int_distribution<unsigned int> targetDistribution(0,size-1);
+    std::uniform_int_distribution<unsigned int> nofChoicesDistribution(2,4);
+    std::uniform_int_distribution<unsigned int> nofEdgesDistribution(2,8);
+    for (unsigned int i=0;i<size;i++) {
+        const double kind = uniform(rng);
+        const bool regionA = (kind<0.01) || (i==size/3);
+        const bool regionB = ((kind>=0.01) && (kind<0.02)) || (i==2*size/3);
+        const bool error = (kind>=0.02) && (kind<0.07) && !regionA && !regionB && (i!=0);
+        model.labels.push_back({regionA,regionB,error});
+    }
+    for (unsigned int i=0;i<size;i++) {
+        model.transitions.addState();
+        const unsigned int nofChoices = nofChoicesDistribution(rng);
+        for (unsigned int c=0;c<nofChoices;c++) {
+            const unsigned int nofEdges = nofEdgesDistribution(rng);
+            std::vector<std::pair<unsigned int,double> > weights;
+            double sum = 0.0;
+            for (unsigned int k=0;k<nofEdges;k++) {
+                const unsigned int target = ((c==0) && (k==0))?((i+1)%size):targetDistribution(rng);
+                const double weight = 0.05+uniform(rng);
+                weights.push_back(std::make_pair(target,weight));
+                sum += weight;
+            }
+            std::map<unsigned int,double> edges;
+            for (auto &weight : weights) edges[weight.first] += weight.second/sum;
+            addChoice(model,c,edges);
+        }
+    }
+    return model;
+}
+
+/**
+ * @brief Chain of strongly connected components: The states form clusters of 16 states each, which are arranged in
+ *        a chain. In every cluster, the states form a ring. The action "stay" moves along the ring, and leaves the
+ *        cluster to the next one with probability 0.1. The action "advance" moves to the next cluster with
+ *        probability 0.5, and back to the first state of the cluster otherwise. Only the last cluster leads back to
+ *        the first one, so that value iteration towards the goal regions has to deal with a long chain of
+ *        components. The first cluster is region A, the middle one region B, and 5% of the other states are error
+ *        states (but never the first state of a cluster).
+ */
+GeneratedModel generateChainModel(unsigned int size, std::mt19937_64 &rng) {
+    GeneratedModel model;
+    model.labelComponents = {"cluster","regionA","regionB","error"};
+    model.actions = {"stay","advance"};
+    const unsigned int clusterSize = 16;
+    const unsigned int nofClusters = std::max(2u,(size+clusterSize-1)/clusterSize);
+    const unsigned int nofStates = nofClusters*clusterSize;
+    std::bernoulli_distribution errorState(0.05);
+    for (unsigned int i=0;i<nofStates;i++) {
+        const unsigned int cluster = i/clusterSize;
+        const bool regionA = cluster==0;
+        const bool regionB = cluster==nofClusters/2;
+        const bool error = errorState(rng) && !regionA && !regionB && (i%clusterSize!=0);
+        model.labels.push_back({cluster,regionA,regionB,error});
+    }
+    for (unsigned int i=0;i<nofStates;i++) {
+        model.transitions.addState();
+        const unsigned int cluster = i/clusterSize;
+        const unsigned int clusterStart = cluster*clusterSize;
+        const unsigned int nextClusterStart = ((cluster+1)%nofClusters)*clusterSize;
+        std::map<unsigned int,double> stay;
+        stay[clusterStart+(i+1-clusterStart)%clusterSize] += 0.9;
+        stay[nextClusterStart] += 0.1;
+        addChoice(model,0,stay);
+        std::map<unsigned int,double> advance;
+        advance[nextClusterStart+(i-clusterStart)] += 0.5;
+        advance[clusterStart] += 0.5;
+        addChoice(model,1,advance);
+    }
+    return model;
+}
+
+/**
+ * @brief Writes a file through a large buffer
+ */
+class BufferedFileWriter {
+private:
+    FILE *file;
+    std::string filename;
+public:
+    BufferedFileWriter(const std::string &_filename) : filename(_filename) {
+        file = fopen(filename.c_str(),"w");
+        if (file==NULL) {
+            std::ostringstream error;
+            error << "Cannot open file '" << filename << "' for writing.";
+            throw error.str();
+        }
+        setvbuf(file,NULL,_IOFBF,1 << 20);
+    }
+    ~BufferedFileWriter() { if (file!=NULL) fclose(file); }
+    FILE *get() { return file; }
+    void close() {
+        const bool failed = ferror(file) || (fclose(file)!=0);
+        file = NULL;
+        if (failed) {
+            std::ostringstream error;
+            error << "Error writing file '" << filename << "'.";
+            throw error.str();
+        }
+    }
+};
+
+}
+
+ModelFamily parseModelFamily(const std::string &name) {
+    if (name=="grid") return GRID_MODEL;
+    if (name=="random") return RANDOM_MODEL;
+    if (name=="chain") return CHAIN_MODEL;
+    std::ostringstream error;
+    error << "Unknown model family '" << name << "'.";
+    throw error.str();
+}
+
+GeneratedModel generateModel(ModelFamily family, unsigned int size, uint64_t seed) {
+    if (size<2) throw "Error: The model size must be at least 2.";
+    std::mt19937_64 rng(seed);
+    switch (family) {
+    case GRID_MODEL:
+        return generateGridModel(size,rng);
+    case RANDOM_MODEL:
+        return generateRandomModel(size,rng);
+    case CHAIN_MODEL:
+        return generateChainModel(size,rng);
+    }
+    throw "Error: Unknown model family.";
+}
+
+void writeModelFiles(const GeneratedModel &model, const std::string &baseFilename) {
+
+    // States
+    {
+        BufferedFileWriter writer(baseFilename+".sta");
+        FILE *file = writer.get();
+        fputc('(',file);
+        for (unsigned int c=0;c<model.labelComponents.size();c++) {
+            fprintf(file,(c==0)?"%s":",%s",model.labelComponents[c].c_str());
+        }
+        fputs(")\n",file);
+        for (unsigned int i=0;i<model.nofStates();i++) {
+            fprintf(file,"%u:(",i);
+            for (unsigned int c=0;c<model.labels[i].size();c++) {
+                fprintf(file,(c==0)?"%u":",%u",model.labels[i][c]);
+            }
+            fputs(")\n",file);
+        }
+        writer.close();
+    }
+
+    // Labels
+    {
+        BufferedFileWriter writer(baseFilename+".lab");
+        fprintf(writer.get(),"0=\"init\" 1=\"deadlock\"\n%u: 0\n",model.initialState);
+        writer.close();
+    }
+
+    // Transitions
+    {
+        const TransitionMatrix &transitions = model.transitions;
+        BufferedFileWriter writer(baseFilename+".tra");
+        FILE *file = writer.get();
+        fprintf(file,"%u %zu %zu\n",model.nofStates(),transitions.choiceActions.size(),transitions.targets.size());
+        for (unsigned int i=0;i<transitions.nofStates();i++) {
+            for (unsigned int j=0;j<transitions.nofChoices(i);j++) {
+                const unsigned int choice = transitions.choiceBegin(i)+j;
+                const int action = transitions.choiceActions[choice];
+                for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+                    fprintf(file,"%u %u %u %.17g",i,j,transitions.targets[k],transitions.probabilities[k]);
+                    if (action!=-1) fprintf(file," %s",model.actions[action].c_str());
+                    fputc('\n',file);
+                }
+            }
+        }
+        writer.close();
+    }
+
+    // Parity automaton
+    {
+        BufferedFileWriter writer(baseFilename+".parity");
+        fputs("1 1 2 3\n"
+              "0 regionA=1 1\n"
+              "0 error=1 3\n"
+              "1 regionB=1 2\n"
+              "1 error=1 3\n"
+              "2 error=0 0\n"
+              "2 error=1 3\n"
+              "3 error=0 0\n",writer.get());
+        writer.close();
+    }
+}
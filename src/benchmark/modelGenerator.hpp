@@ -0,0 +1,56 @@
+#ifndef __MODEL_GENERATOR_HPP____
+#define __MODEL_GENERATOR_HPP____
+
+#include "../mdp.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief An MDP produced by the model generator. The states have numeric label components, and the choices refer
+ *        to the action names by their number (as in "MDP"). Every model has the label components "regionA",
+ *        "regionB", and "error" (with values 0 and 1), which the generated parity automaton refers to.
+ */
+struct GeneratedModel {
+    std::vector<std::string> labelComponents;
+    std::vector<std::vector<unsigned int> > labels; // For every state: The values of the label components
+    std::vector<std::string> actions;
+    TransitionMatrix transitions;
+    unsigned int initialState;
+    GeneratedModel() : initialState(0) {}
+    unsigned int nofStates() const { return labels.size(); }
+};
+
+/**
+ * @brief The families of models that can be generated
+ */
+enum ModelFamily {
+    GRID_MODEL, // A grid world like the unicycle example: size*size cells, some of which are error cells
+    RANDOM_MODEL, // A random sparse MDP with size states
+    CHAIN_MODEL // A chain of small strongly connected components with size states in total
+};
+
+/**
+ * @brief Parses the name of a model family ("grid", "random", or "chain"). Throws an error for other names.
+ */
+ModelFamily parseModelFamily(const std::string &name);
+
+/**
+ * @brief Generates a model. The same parameters always lead to the same model.
+ * @param family The kind of model
+ * @param size The size parameter (see "ModelFamily")
+ * @param seed The seed of the random number generator
+ * @return The model
+ */
+GeneratedModel generateModel(ModelFamily family, unsigned int size, uint64_t seed);
+
+/**
+ * @brief Writes a generated model as the ".sta", ".lab", and ".tra" files that RAMPS reads, together with a parity
+ *        automaton (".parity") that requires the regions A and B to be visited alternately infinitely often, while
+ *        error states are visited only finitely often.
+ * @param model The model
+ * @param baseFilename The file name prefix
+ */
+void writeModelFiles(const GeneratedModel &model, const std::string &baseFilename);
+
+#endif
@@ -0,0 +1,464 @@
+#include "mdp.hpp"
+#include "memoryMappedFile.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+//=====================================================
+// Binary MDP files
+//
+// A binary MDP file stores an MDP in the native byte
+// order of the machine, so that it can be loaded by
+// memory-mapping it and copying the arrays of the
+// transition relation in bulk. The layout is:
+//
+// - The magic bytes "RAMPSMDP"
+// - A byte order mark (uint32_t 0x01020304) and the
+//   format version (uint32_t)
+// - The number of label components, actions, states,
+//   choices and edges as well as the initial state
+//   (uint32_t each)
+// - The label component names and action names
+// - For every label component: the number of distinct
+//   values, followed by the values
+// - The label values of all states as indices into the
+//   value lists, state by state (uint32_t each)
+// - The arrays of the transition matrix, each starting
+//   at an offset divisible by 8
+//
+// Strings are stored as their length (uint32_t)
+// followed by their characters.
+//=====================================================
+
+namespace {
+
+const char binaryMDPMagic[8] = {'R','A','M','P','S','M','D','P'};
+const uint32_t binaryMDPByteOrderMark = 0x01020304;
+const uint32_t binaryMDPVersion = 1;
+
+/**
+ * @brief Writes the data types used in binary MDP files
+ */
+class BinaryMDPWriter {
+private:
+    std::ofstream &out;
+    uint64_t position;
+public:
+    BinaryMDPWriter(std::ofstream &_out) : out(_out), position(0) {}
+    void writeBytes(const void *data, size_t size) {
+        out.write(static_cast<const char*>(data),size);
+        position += size;
+    }
+    void writeUInt32(uint32_t value) { writeBytes(&value,sizeof(value)); }
+    void writeString(const std::string &value) {
+        writeUInt32(value.size());
+        writeBytes(value.data(),value.size());
+    }
+    template<class T> void writeArray(const std::vector<T> &values) {
+        while ((position % 8)!=0) {
+            char zero = 0;
+            writeBytes(&zero,1);
+        }
+        writeBytes(values.data(),values.size()*sizeof(T));
+    }
+};
+
+/**
+ * @brief Reads the data types used in binary MDP files from a memory-mapped file. Throws an error when reading
+ *        beyond the end of the file.
+ */
+class BinaryMDPReader {
+private:
+    const char *start;
+    const char *pos;
+    const char *end;
+    void need(size_t size) const {
+        if (static_cast<size_t>(end-pos)<size) throw "Error: The binary MDP file is truncated.";
+    }
+public:
+    BinaryMDPReader(const char *_start, const char *_end) : start(_start), pos(_start), end(_end) {}
+    void readBytes(void *data, size_t size) {
+        need(size);
+        memcpy(data,pos,size);
+        pos += size;
+    }
+    uint32_t readUInt32() {
+        uint32_t value;
+        readBytes(&value,sizeof(value));
+        return value;
+    }
+    std::string readString() {
+        uint32_t size = readUInt32();
+        need(size);
+        std::string value(pos,size);
+        pos += size;
+        return value;
+    }
+    template<class T> void readArray(std::vector<T> &values, size_t nofElements) {
+        while (((pos-start) % 8)!=0) pos++;
+        if (pos>end) throw "Error: The binary MDP file is truncated.";
+        need(nofElements*sizeof(T));
+        values.resize(nofElements);
+        memcpy(values.data(),pos,nofElements*sizeof(T));
+        pos += nofElements*sizeof(T);
+    }
+    bool atEnd() const { return pos==end; }
+};
+
+}
+
+/**
+ * @brief Writes the MDP to a binary file that can later be read much faster than the PRISM files.
+ * @param filename The name of the binary file (including its suffix)
+ */
+void MDP::writeBinaryFile(std::string filename) const {
+    std::ofstream outFile(filename,std::ios::binary);
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Cannot open binary MDP file '" << filename << "' for writing.";
+        throw error.str();
+    }
+    BinaryMDPWriter writer(outFile);
+
+    // Header
+    writer.writeBytes(binaryMDPMagic,sizeof(binaryMDPMagic));
+    writer.writeUInt32(binaryMDPByteOrderMark);
+    writer.writeUInt32(binaryMDPVersion);
+    writer.writeUInt32(labelComponents.size());
+    writer.writeUInt32(actions.size());
+    writer.writeUInt32(nofStates());
+    writer.writeUInt32(transitions.choiceActions.size());
+    writer.writeUInt32(transitions.targets.size());
+    writer.writeUInt32(initialState);
+    for (auto &component : labelComponents) writer.writeString(component);
+    for (auto &action : actions) writer.writeString(action);
+
+    // State labels: The values are already interned, so the dictionaries can be written directly and the
+    // columns only need to be interleaved
+    const unsigned int nofLabelComponents = labels.nofComponents();
+    std::vector<uint32_t> labelValueIndices((size_t)nofStates()*nofLabelComponents);
+    for (unsigned int c=0;c<nofLabelComponents;c++) {
+        const std::vector<std::string> &dictionary = labels.dictionary(c);
+        writer.writeUInt32(dictionary.size());
+        for (auto &value : dictionary) writer.writeString(value);
+        const std::vector<uint32_t> &column = labels.column(c);
+        for (unsigned int i=0;i<nofStates();i++) labelValueIndices[(size_t)i*nofLabelComponents+c] = column[i];
+    }
+    writer.writeArray(labelValueIndices);
+
+    // Transitions
+    writer.writeArray(transitions.stateOffsets);
+    writer.writeArray(transitions.choiceOffsets);
+    writer.writeArray(transitions.choiceActions);
+    writer.writeArray(transitions.probabilities);
+    writer.writeArray(transitions.targets);
+
+    outFile.close();
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Error writing binary MDP file '" << filename << "'.";
+        throw error.str();
+    }
+}
+
+/**
+ * @brief Reads an MDP from a file written by "writeBinaryFile". The file is memory-mapped, and the arrays of the
+ *        transition relation are copied in bulk, without any parsing.
+ * @param filename The name of the binary file (including its suffix)
+ */
+void MDP::readBinaryFile(std::string filename) {
+    MemoryMappedFile file(filename);
+    if (file.fail()) {
+        std::cerr << "Error: Could not open binary MDP file " << filename << std::endl;
+        throw 1;
+    }
+    BinaryMDPReader reader(file.begin(),file.end());
+
+    // Header
+    char magic[sizeof(binaryMDPMagic)];
+    reader.readBytes(magic,sizeof(magic));
+    if (memcmp(magic,binaryMDPMagic,sizeof(magic))!=0) throw "Error: The binary MDP file does not start with the correct magic bytes.";
+    if (reader.readUInt32()!=binaryMDPByteOrderMark) throw "Error: The binary MDP file has been written on a machine with a different byte order.";
+    if (reader.readUInt32()!=binaryMDPVersion) throw "Error: Unsupported binary MDP file version.";
+    const uint32_t nofLabelComponents = reader.readUInt32();
+    const uint32_t nofActions = reader.readUInt32();
+    const uint32_t nofStates = reader.readUInt32();
+    const uint32_t nofChoices = reader.readUInt32();
+    const uint32_t nofEdges = reader.readUInt32();
+    initialState = reader.readUInt32();
+    for (unsigned int i=0;i<nofLabelComponents;i++) labelComponents.push_back(reader.readString());
+    for (unsigned int i=0;i<nofActions;i++) actions.push_back(reader.readString());
+
+    // State labels
+    std::vector<std::vector<std::string> > labelValues(nofLabelComponents);
+    for (unsigned int c=0;c<nofLabelComponents;c++) {
+        const uint32_t nofValues = reader.readUInt32();
+        for (unsigned int i=0;i<nofValues;i++) labelValues[c].push_back(reader.readString());
+    }
+    std::vector<uint32_t> labelValueIndices;
+    reader.readArray(labelValueIndices,(size_t)nofStates*nofLabelComponents);
+    labels.setNofComponents(nofLabelComponents,nofStates);
+    for (unsigned int c=0;c<nofLabelComponents;c++) {
+        std::vector<uint32_t> column(nofStates);
+        for (unsigned int i=0;i<nofStates;i++) {
+            const uint32_t index = labelValueIndices[(size_t)i*nofLabelComponents+c];
+            if (index>=labelValues[c].size()) throw "Error: Illegal state label in the binary MDP file.";
+            column[i] = index;
+        }
+        labels.setComponent(c,labelValues[c],column);
+    }
+
+    // Transitions
+    reader.readArray(transitions.stateOffsets,(size_t)nofStates+1);
+    reader.readArray(transitions.choiceOffsets,(size_t)nofChoices+1);
+    reader.readArray(transitions.choiceActions,nofChoices);
+    reader.readArray(transitions.probabilities,nofEdges);
+    reader.readArray(transitions.targets,nofEdges);
+    if (!reader.atEnd()) throw "Error: The binary MDP file has trailing data.";
+
+    // Sanity checks so that corrupted files do not lead to out-of-bounds accesses later
+    if ((initialState>=nofStates) && (initialState!=(unsigned int)-1)) throw "Error: Illegal initial state in the binary MDP file.";
+    if ((transitions.stateOffsets[0]!=0) || (transitions.stateOffsets[nofStates]!=nofChoices)) throw "Error: Illegal state offsets in the binary MDP file.";
+    if ((transitions.choiceOffsets[0]!=0) || (transitions.choiceOffsets[nofChoices]!=nofEdges)) throw "Error: Illegal choice offsets in the binary MDP file.";
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (transitions.stateOffsets[i]>transitions.stateOffsets[i+1]) throw "Error: Illegal state offsets in the binary MDP file.";
+    }
+    for (unsigned int i=0;i<nofChoices;i++) {
+        if (transitions.choiceOffsets[i]>transitions.choiceOffsets[i+1]) throw "Error: Illegal choice offsets in the binary MDP file.";
+        if ((transitions.choiceActions[i]<-1) || (transitions.choiceActions[i]>=(int)nofActions)) throw "Error: Illegal action in the binary MDP file.";
+    }
+    for (unsigned int i=0;i<nofEdges;i++) {
+        if (transitions.targets[i]>=nofStates) throw "Error: Illegal transition target in the binary MDP file.";
+    }
+}
+
+//=====================================================
+// Binary strategy files
+//
+// The layout is similar to the one of binary MDP files:
+//
+// - The magic bytes "RAMPSSTR"
+// - A byte order mark (uint32_t 0x01020304) and the
+//   format version (uint32_t)
+// - The number of entries and memory updates
+//   (uint32_t each)
+// - The states, data states, MDP states and actions of
+//   the entries, the offsets of the memory updates of
+//   the entries (one more than there are entries), and
+//   the MDP states, states and data states of the
+//   memory updates. These are arrays of uint32_t, each
+//   starting at an offset divisible by 8.
+//=====================================================
+
+namespace {
+
+const char binaryStrategyMagic[8] = {'R','A','M','P','S','S','T','R'};
+const uint32_t binaryStrategyVersion = 1;
+
+}
+
+/**
+ * @brief Writes the strategy to a binary file. It contains the same information as the text format
+ *        (see "writeText"), but can be written and read much faster.
+ * @param filename The name of the binary file
+ * @param mdpStates The MDP state of every state of the strategy
+ */
+void Strategy::writeBinaryFile(std::string filename, const std::vector<unsigned int> &mdpStates) const {
+    std::ofstream outFile(filename,std::ios::binary);
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Cannot open binary strategy file '" << filename << "' for writing.";
+        throw error.str();
+    }
+    BinaryMDPWriter writer(outFile);
+
+    writer.writeBytes(binaryStrategyMagic,sizeof(binaryStrategyMagic));
+    writer.writeUInt32(binaryMDPByteOrderMark);
+    writer.writeUInt32(binaryStrategyVersion);
+    writer.writeUInt32(entryStates.size());
+    writer.writeUInt32(updateStates.size());
+
+    std::vector<uint32_t> entryMDPStates(entryStates.size());
+    for (unsigned int i=0;i<entryStates.size();i++) entryMDPStates[i] = mdpStates.at(entryStates[i]);
+    std::vector<uint32_t> updateMDPStates(updateStates.size());
+    for (unsigned int k=0;k<updateStates.size();k++) updateMDPStates[k] = mdpStates.at(updateStates[k]);
+    writer.writeArray(entryStates);
+    writer.writeArray(entryDataStates);
+    writer.writeArray(entryMDPStates);
+    writer.writeArray(entryActions);
+    writer.writeArray(updateOffsets);
+    writer.writeArray(updateMDPStates);
+    writer.writeArray(updateStates);
+    writer.writeArray(updateDataStates);
+
+    outFile.close();
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Error writing binary strategy file '" << filename << "'.";
+        throw error.str();
+    }
+}
+
+//=====================================================
+// Value iteration result files
+//
+// They store the entries of a value iteration cache,
+// so that a later run for a changed version of the MDP
+// can reuse them (see "setPreviousVersion"). The layout
+// is similar to the one of binary MDP files:
+//
+// - The magic bytes "RAMPSVIR"
+// - A byte order mark (uint32_t 0x01020304) and the
+//   format version (uint32_t)
+// - The number of states and edges of the parity MDP
+//   that the results have been computed for, and the
+//   number of entries (uint32_t each)
+// - The fingerprints of the parity automaton and of
+//   the parity MDP (uint64_t each, see
+//   "ParityMDP::fingerprint")
+// - For every entry: the minimal goal color, the
+//   settings (computePolicyEagerly, method,
+//   intervalIteration, singlePrecision, warmStart),
+//   and the numbers of goal states, winning states,
+//   values and upper bounds (uint32_t each), followed
+//   by epsilon (double). Then the goal states, the
+//   winning states, the values, the policy choices,
+//   and the upper bounds follow as arrays, each
+//   starting at an offset divisible by 8.
+//
+// Entries are stored from the most recently used one
+// to the least recently used one.
+//=====================================================
+
+namespace {
+
+const char valueIterationResultsMagic[8] = {'R','A','M','P','S','V','I','R'};
+const uint32_t valueIterationResultsVersion = 2;
+
+}
+
+/**
+ * @brief Writes the results in the cache to a file, from which "readFile" can restore them.
+ * @param filename The name of the file
+ * @param automaton The parity automaton the results belong to
+ * @param parityMDP The parity MDP the results belong to
+ */
+void ValueIterationCache::writeFile(std::string filename, const ParityAutomaton &automaton, const ParityMDP &parityMDP) const {
+    std::ofstream outFile(filename,std::ios::binary);
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Cannot open value iteration result file '" << filename << "' for writing.";
+        throw error.str();
+    }
+    BinaryMDPWriter writer(outFile);
+
+    writer.writeBytes(valueIterationResultsMagic,sizeof(valueIterationResultsMagic));
+    writer.writeUInt32(binaryMDPByteOrderMark);
+    writer.writeUInt32(valueIterationResultsVersion);
+    writer.writeUInt32(parityMDP.nofStates());
+    writer.writeUInt32(parityMDP.nofEdges());
+    writer.writeUInt32(entries.size());
+    const uint64_t fingerprints[2] = {automaton.fingerprint(),parityMDP.fingerprint()};
+    writer.writeBytes(fingerprints,sizeof(fingerprints));
+    for (const Entry &entry : entries) {
+        writer.writeUInt32(entry.key.minGoalColor);
+        writer.writeUInt32(entry.key.computePolicyEagerly);
+        writer.writeUInt32(entry.key.method);
+        writer.writeUInt32(entry.key.intervalIteration);
+        writer.writeUInt32(entry.key.singlePrecision);
+        writer.writeUInt32(entry.key.warmStart);
+        writer.writeUInt32(entry.key.goalStates.size());
+        writer.writeUInt32(entry.key.winningStates.size());
+        writer.writeUInt32(entry.values.size());
+        writer.writeUInt32(entry.upperBounds.size());
+        writer.writeBytes(&(entry.key.epsilon),sizeof(double));
+        std::vector<double> values(entry.values.size());
+        std::vector<uint32_t> choices(entry.values.size());
+        for (unsigned int i=0;i<entry.values.size();i++) {
+            values[i] = entry.values[i].first;
+            choices[i] = entry.values[i].second;
+        }
+        writer.writeArray(entry.key.goalStates);
+        writer.writeArray(entry.key.winningStates);
+        writer.writeArray(values);
+        writer.writeArray(choices);
+        writer.writeArray(entry.upperBounds);
+    }
+
+    outFile.close();
+    if (outFile.fail()) {
+        std::ostringstream error;
+        error << "Error writing value iteration result file '" << filename << "'.";
+        throw error.str();
+    }
+}
+
+/**
+ * @brief Adds the results from a file written by "writeFile" to the cache. As they are only valid for the parity
+ *        MDP they have been computed for, the size and the fingerprints of the parity automaton and of the parity
+ *        MDP are compared to the ones stored in the file.
+ * @param filename The name of the file
+ * @param automaton The parity automaton
+ * @param parityMDP The parity MDP
+ */
+void ValueIterationCache::readFile(std::string filename, const ParityAutomaton &automaton, const ParityMDP &parityMDP) {
+    MemoryMappedFile file(filename);
+    if (file.fail()) {
+        std::ostringstream error;
+        error << "Could not open value iteration result file '" << filename << "'.";
+        throw error.str();
+    }
+    BinaryMDPReader reader(file.begin(),file.end());
+
+    char magic[sizeof(valueIterationResultsMagic)];
+    reader.readBytes(magic,sizeof(magic));
+    if (memcmp(magic,valueIterationResultsMagic,sizeof(magic))!=0) throw "The value iteration result file does not start with the correct magic bytes.";
+    if (reader.readUInt32()!=binaryMDPByteOrderMark) throw "The value iteration result file has been written on a machine with a different byte order.";
+    if (reader.readUInt32()!=valueIterationResultsVersion) throw "Unsupported value iteration result file version.";
+    const unsigned int nofStates = parityMDP.nofStates();
+    if ((reader.readUInt32()!=nofStates) || (reader.readUInt32()!=parityMDP.nofEdges())) throw "The value iteration result file has been written for a different product of the MDP and the parity automaton.";
+    const uint32_t nofEntries = reader.readUInt32();
+    uint64_t fingerprints[2];
+    reader.readBytes(fingerprints,sizeof(fingerprints));
+    if (fingerprints[0]!=automaton.fingerprint()) throw "The value iteration result file has been written for a different parity automaton.";
+    if (fingerprints[1]!=parityMDP.fingerprint()) throw "The value iteration result file has been written for a different version of the MDP than the previous one.";
+    std::vector<Entry> fileEntries(nofEntries);
+    for (Entry &entry : fileEntries) {
+        entry.key.minGoalColor = reader.readUInt32();
+        entry.key.computePolicyEagerly = reader.readUInt32();
+        const uint32_t method = reader.readUInt32();
+        if (method>ValueIterationSettings::DISTRIBUTED) throw "Illegal value iteration method in the value iteration result file.";
+        entry.key.method = (ValueIterationSettings::Method)method;
+        entry.key.intervalIteration = reader.readUInt32();
+        entry.key.singlePrecision = reader.readUInt32();
+        entry.key.warmStart = reader.readUInt32();
+        const uint32_t nofGoalStates = reader.readUInt32();
+        const uint32_t nofWinningStates = reader.readUInt32();
+        const uint32_t nofValues = reader.readUInt32();
+        const uint32_t nofUpperBounds = reader.readUInt32();
+        reader.readBytes(&(entry.key.epsilon),sizeof(double));
+        std::vector<double> values;
+        std::vector<uint32_t> choices;
+        reader.readArray(entry.key.goalStates,nofGoalStates);
+        reader.readArray(entry.key.winningStates,nofWinningStates);
+        reader.readArray(values,nofValues);
+        reader.readArray(choices,nofValues);
+        reader.readArray(entry.upperBounds,nofUpperBounds);
+        if ((nofValues!=nofStates) && (nofValues!=2*nofStates)) throw "Illegal number of values in the value iteration result file.";
+        for (unsigned int state : entry.key.goalStates) {
+            if (state>=nofStates) throw "Illegal goal state in the value iteration result file.";
+        }
+        for (unsigned int state : entry.key.winningStates) {
+            if (state>=nofStates) throw "Illegal winning state in the value iteration result file.";
+        }
+        entry.values.resize(nofValues);
+        for (unsigned int i=0;i<nofValues;i++) entry.values[i] = std::pair<double,unsigned int>(values[i],choices[i]);
+    }
+    if (!reader.atEnd()) throw "The value iteration result file has trailing data.";
+
+    // Inserting the least recently used entry first keeps the order of the entries
+    for (auto it = fileEntries.rbegin();it!=fileEntries.rend();it++) insert(it->key,it->values,it->upperBounds.empty()?NULL:&(it->upperBounds));
+}
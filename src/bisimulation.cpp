@@ -0,0 +1,193 @@
+#include "mdp.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+//=====================================================
+// Bisimulation quotient
+//
+// The quotient is computed by partition refinement
+// with signatures. Initially, states are in the same
+// block if they agree on the relevant label
+// components. In every round, the signature of a
+// state consists of its block and the set of the
+// signatures of its choices. The signature of a choice
+// consists of its action (if it is relevant) and the
+// probabilities to move to each block. States are in
+// the same block in the next round if they have the
+// same signature. This is repeated until the number of
+// blocks does not change any more.
+//
+// Probabilities are summed up in a canonical order, so
+// that bisimilar states get the same signatures in
+// floating point arithmetic whenever they have the same
+// edges, just in a different order.
+//=====================================================
+
+namespace {
+
+struct SignatureHash {
+    inline std::size_t operator()(const std::vector<uint64_t> &signature) const {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint64_t part : signature) {
+            hash = (hash ^ part)*1099511628211ull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+};
+
+/**
+ * @brief Computes the probabilities with which a choice leads to the blocks of a partition.
+ * @param transitions The transition relation
+ * @param choice The choice
+ * @param blocks The block of every state
+ * @param blockProbabilities Is set to the blocks and probabilities, sorted by block
+ */
+void computeBlockProbabilities(const TransitionMatrix &transitions, unsigned int choice, const std::vector<unsigned int> &blocks, std::vector<std::pair<unsigned int,double> > &blockProbabilities) {
+    std::vector<std::pair<unsigned int,double> > edges;
+    for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+        edges.push_back(std::pair<unsigned int,double>(blocks[transitions.targets[k]],transitions.probabilities[k]));
+    }
+    std::sort(edges.begin(),edges.end());
+    blockProbabilities.clear();
+    for (auto &edge : edges) {
+        if ((blockProbabilities.size()>0) && (blockProbabilities.back().first==edge.first)) {
+            blockProbabilities.back().second += edge.second;
+        } else {
+            blockProbabilities.push_back(edge);
+        }
+    }
+}
+
+/**
+ * @brief Computes the signature of a choice with respect to a partition (see above).
+ * @param mdp The MDP
+ * @param choice The choice
+ * @param relevantActions Which actions need to be distinguished
+ * @param blocks The block of every state
+ * @param signature Is set to the signature
+ */
+void computeChoiceSignature(const MDP &mdp, unsigned int choice, const std::vector<bool> &relevantActions, const std::vector<unsigned int> &blocks, std::vector<uint64_t> &signature) {
+    const int action = mdp.transitions.choiceActions[choice];
+    std::vector<std::pair<unsigned int,double> > blockProbabilities;
+    computeBlockProbabilities(mdp.transitions,choice,blocks,blockProbabilities);
+    signature.clear();
+    signature.push_back(((action!=-1) && relevantActions[action])?action:(uint64_t)-1);
+    for (auto &blockProbability : blockProbabilities) {
+        uint64_t probabilityBits;
+        memcpy(&probabilityBits,&blockProbability.second,sizeof(probabilityBits));
+        signature.push_back(blockProbability.first);
+        signature.push_back(probabilityBits);
+    }
+}
+
+/**
+ * @brief Computes the signature of a state with respect to a partition (see above).
+ * @param mdp The MDP
+ * @param state The state
+ * @param relevantActions Which actions need to be distinguished
+ * @param blocks The block of every state
+ * @param signature Is set to the signature
+ */
+void computeStateSignature(const MDP &mdp, unsigned int state, const std::vector<bool> &relevantActions, const std::vector<unsigned int> &blocks, std::vector<uint64_t> &signature) {
+    std::vector<std::vector<uint64_t> > choiceSignatures(mdp.transitions.nofChoices(state));
+    for (unsigned int j=0;j<choiceSignatures.size();j++) {
+        computeChoiceSignature(mdp,mdp.transitions.choiceBegin(state)+j,relevantActions,blocks,choiceSignatures[j]);
+    }
+    std::sort(choiceSignatures.begin(),choiceSignatures.end());
+    choiceSignatures.erase(std::unique(choiceSignatures.begin(),choiceSignatures.end()),choiceSignatures.end());
+    signature.clear();
+    signature.push_back(blocks[state]);
+    for (auto &choiceSignature : choiceSignatures) {
+        signature.push_back(choiceSignature.size());
+        signature.insert(signature.end(),choiceSignature.begin(),choiceSignature.end());
+    }
+}
+
+}
+
+/**
+ * @brief Computes the quotient of an MDP under probabilistic bisimulation, where only the given label components
+ *        and actions are observable. The states of the quotient are numbered in the order of the first original
+ *        state in them, and every quotient state has the choices and the label of this first state.
+ * @param original The MDP to minimize
+ * @param relevantComponents For every label component: whether states with different values must be distinguished
+ * @param relevantActions For every action: whether it must be distinguished from other actions
+ * @param mapping Is set to the relation between the original MDP and the quotient
+ */
+MDP::MDP(const MDP &original, const std::vector<bool> &relevantComponents, const std::vector<bool> &relevantActions, BisimulationQuotientMapping &mapping) : actions(original.actions), labelComponents(original.labelComponents), initialState(-1) {
+    const unsigned int nofOriginalStates = original.transitions.nofStates();
+    std::vector<unsigned int> &blocks = mapping.quotientStates;
+    unsigned int nofBlocks;
+
+    // Initial partition: By the relevant label components
+    {
+        std::unordered_map<std::vector<uint64_t>,unsigned int,SignatureHash> blockNumbers;
+        std::vector<uint64_t> signature;
+        blocks.resize(nofOriginalStates);
+        for (unsigned int i=0;i<nofOriginalStates;i++) {
+            signature.clear();
+            for (unsigned int c=0;c<original.labels.nofComponents();c++) {
+                if (relevantComponents[c]) signature.push_back(original.labels.valueNumber(i,c));
+            }
+            blocks[i] = blockNumbers.insert(std::make_pair(signature,(unsigned int)blockNumbers.size())).first->second;
+        }
+        nofBlocks = blockNumbers.size();
+    }
+
+    // Refine until stable. The signatures are computed in parallel, and the blocks are numbered sequentially,
+    // in the order of the first state in them.
+    std::vector<std::vector<uint64_t> > signatures(nofOriginalStates);
+    bool stable = false;
+    while (!stable) {
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (unsigned int i=0;i<nofOriginalStates;i++) {
+            computeStateSignature(original,i,relevantActions,blocks,signatures[i]);
+        }
+        std::unordered_map<std::vector<uint64_t>,unsigned int,SignatureHash> blockNumbers;
+        for (unsigned int i=0;i<nofOriginalStates;i++) {
+            blocks[i] = blockNumbers.insert(std::make_pair(std::move(signatures[i]),(unsigned int)blockNumbers.size())).first->second;
+        }
+        stable = blockNumbers.size()==nofBlocks;
+        nofBlocks = blockNumbers.size();
+    }
+    signatures.clear();
+
+    // Build the quotient from the first state of every block
+    std::vector<unsigned int> representatives(nofBlocks,(unsigned int)-1);
+    for (unsigned int i=0;i<nofOriginalStates;i++) {
+        if (representatives[blocks[i]]==(unsigned int)-1) representatives[blocks[i]] = i;
+    }
+    labels.setNofComponents(labelComponents.size());
+    std::vector<std::pair<unsigned int,double> > blockProbabilities;
+    for (unsigned int b=0;b<nofBlocks;b++) {
+        const unsigned int representative = representatives[b];
+        labels.addState(original.labels.label(representative));
+        transitions.addState();
+        for (unsigned int choice=original.transitions.choiceBegin(representative);choice<original.transitions.choiceEnd(representative);choice++) {
+            transitions.addChoice(original.transitions.choiceActions[choice]);
+            computeBlockProbabilities(original.transitions,choice,blocks,blockProbabilities);
+            for (auto &blockProbability : blockProbabilities) transitions.addEdge(blockProbability.second,blockProbability.first);
+        }
+    }
+    labels.finishAddingStates();
+    if (original.initialState!=(unsigned int)-1) initialState = blocks[original.initialState];
+
+    // Map every original choice to the choice of its quotient state with the same signature
+    mapping.quotientChoices.resize(original.transitions.choiceActions.size());
+    #pragma omp parallel for schedule(dynamic,1024)
+    for (unsigned int i=0;i<nofOriginalStates;i++) {
+        const unsigned int representative = representatives[blocks[i]];
+        std::vector<std::vector<uint64_t> > representativeSignatures(original.transitions.nofChoices(representative));
+        for (unsigned int j=0;j<representativeSignatures.size();j++) {
+            computeChoiceSignature(original,original.transitions.choiceBegin(representative)+j,relevantActions,blocks,representativeSignatures[j]);
+        }
+        std::vector<uint64_t> signature;
+        for (unsigned int choice=original.transitions.choiceBegin(i);choice<original.transitions.choiceEnd(i);choice++) {
+            computeChoiceSignature(original,choice,relevantActions,blocks,signature);
+            mapping.quotientChoices[choice] = std::find(representativeSignatures.begin(),representativeSignatures.end(),signature)-representativeSignatures.begin();
+        }
+    }
+}
@@ -1,6 +1,6 @@
 #include "mdp.hpp"
+#include "valueIteration.hpp"
 #include <map>
-#include <set>
 #include <cassert>
 #include <cmath>
 #include <limits>
@@ -9,229 +9,114 @@
 #include <cstring>
 
 
-// TypeDefs
-typedef std::set<unsigned int> StateSetType;
-
-
 /**
- * @brief The Value iteration function for reachability MDPs. There are two variants of this function.
- * @param fixedValues MDP states that are goals or non-goals
- * @param epsilon The cutoff value for value iteration
- * @param computePolicyEagerly Whether the strategy should be computed eagerly, i.e., at every step of the value iteration process. This is necessary
- *        if we have MDPs with strongly connected components of states that have all the same value, as no strategy reconstruction
- *        can be made from their values
- * @return The state values and the policy
+ * @brief The Value iteration function for reachability MDPs - see "performValueIteration" for details.
  */
-std::vector<std::pair<double,unsigned int> > MDP::valueIteration(const std::map<unsigned int, double> &fixedValues, double epsilon, bool computePolicyEagerly) const {
-
-    if (computePolicyEagerly) {
-
-        //=========================================
-        // Eager Policy Computation
-        //=========================================
-
-        // Initialize result
-        std::vector<bool> touchable(states.size());
-        //double *oldValues = new double[states.size()];
-        double *newValues = new double[states.size()];
-        unsigned int *currentPolicy = new unsigned int[states.size()];
-
-        for (unsigned int i=0;i<states.size();i++) {
-            newValues[i] = 0.0;
-            touchable[i] = true;
-            currentPolicy[i] = 0;
-        }
-        for (auto &a : fixedValues) {
-            newValues[a.first] = a.second;
-            touchable[a.first] = false;
-        }
-
-        // Perform iteration - this time don't write the best direction
-        double diff = 2*epsilon;
-        while (diff > epsilon) {
-
-            diff = 0.0;
-
-            #pragma omp parallel for reduction (+:diff)
-            for (unsigned int i=0;i<states.size();i++) {
-                if (touchable[i]) {
-                    double bestValue = 0.0;
-                    unsigned int bestDirection = (unsigned int)-1;
-                    for (unsigned int j=0;j<transitions[i].size();j++) {
-                        auto const &a = transitions[i][j];
-                        double newValue = 0.0;
-                        for (const auto &e : a.edges) {
-                            newValue += e.first*newValues[e.second];
-                        }
-                        if (newValue > bestValue) {
-                            bestValue = newValue;
-                            bestDirection = j;
-                        }
-                    }
-                    if (bestValue > newValues[i]) {
-                        diff += (bestValue - newValues[i]);
-                        newValues[i] = bestValue;
-                        currentPolicy[i] = bestDirection;
-                    }
-                }
-            }
-        }
-
-        // Now build the value+action result
-        std::vector<std::pair<double,unsigned int> > result(states.size());
-        #pragma omp parallel for
-        for (unsigned int i=0;i<states.size();i++) {
-            result[i] = std::pair<double,unsigned int>(newValues[i],currentPolicy[i]);
-        }
-
-        delete[] newValues;
-        delete[] currentPolicy;
-
-        // Now recompute all fixed-probability values
-        for (unsigned int i=0;i<states.size();i++) {
-            if (!(touchable[i])) {
-                double bestValue = 0.0;
-                unsigned int dir = 0;
-                for (unsigned int j=0;j<transitions[i].size();j++) {
-                    auto &a = transitions[i][j];
-                    double newValue = 0.0;
-                    for (auto &e : a.edges) {
-                        if (fixedValues.count(e.second)>0) {
-                            newValue += e.first*fixedValues.at(e.second);
-                        } else {
-                            newValue += e.first*result[e.second].first;
-                        }
-                    }
-                    if (newValue > bestValue) {
-                        bestValue = newValue;
-                        dir = j;
-                    }
-                }
-                result[i] = std::pair<double,unsigned int>(std::nextafter(bestValue,0.0),dir);
-            }
-            assert(result[i].second < transitions[i].size());
-        }
-
-        return result;
-
-    } else {
-
-        //=========================================
-        // Non-Eager Policy Computation
-        //=========================================
+std::vector<std::pair<double,unsigned int> > MDP::valueIteration(const FixedValues &fixedValues, const ValueIterationSettings &settings, const std::vector<std::pair<double,unsigned int> > *initialValues, bool initialValuesAreUpperBounds) const {
+    ValueIterationHints hints;
+    hints.initialValues = initialValues;
+    hints.initialValuesAreUpperBounds = initialValuesAreUpperBounds;
+    return performValueIteration(transitions,fixedValues,settings,hints);
+}
 
-        // Initialize result
-        std::vector<bool> touchable(states.size());
-        //double *oldValues = new double[states.size()];
-        double *newValues = new double[states.size()];
 
-        for (unsigned int i=0;i<states.size();i++) {
-            newValues[i] = 0.0;
-            touchable[i] = true;
-        }
-        for (auto &a : fixedValues) {
-            newValues[a.first] = a.second;
-            touchable[a.first] = false;
-        }
+/**
+ * @brief Builds the key under which the result of a value iteration call in computeRAPolicy is cached.
+ */
+ValueIterationCache::Key makeValueIterationCacheKey(unsigned int minGoalColor, const StateSet &goalStates, const StateSet &winningStates, const ValueIterationSettings &settings) {
+    ValueIterationCache::Key key;
+    key.minGoalColor = minGoalColor;
+    key.goalStates = goalStates.toVector();
+    key.winningStates = winningStates.toVector();
+    key.epsilon = settings.epsilon;
+    key.computePolicyEagerly = settings.computePolicyEagerly;
+    key.method = settings.method;
+    key.intervalIteration = settings.intervalIteration;
+    key.singlePrecision = settings.singlePrecision;
+    key.warmStart = settings.warmStart;
+    return key;
+}
 
-        // Perform iteration - this time don't write the best direction
-        double diff = 2*epsilon;
-        while (diff > epsilon) {
-
-            diff = 0.0;
-
-            #pragma omp parallel for reduction (+:diff)
-            for (unsigned int i=0;i<states.size();i++) {
-                if (touchable[i]) {
-                    double bestValue = 0.0;
-                    for (unsigned int j=0;j<transitions[i].size();j++) {
-                        auto const &a = transitions[i][j];
-                        double newValue = 0.0;
-                        for (const auto &e : a.edges) {
-                            newValue += e.first*newValues[e.second];
-                        }
-                        if (newValue > bestValue) {
-                            bestValue = newValue;
-                        }
-                    }
-                    diff += std::abs(bestValue - newValues[i]);
-                    newValues[i] = std::nextafter(bestValue,0.0);
-                }
+/**
+ * @brief Looks up a value iteration result in the cache
+ * @param key The value iteration problem
+ * @param values Is set to the result if it is found
+ * @param upperBounds If not NULL, is set to the upper bounds stored with the result if it is found
+ * @return true if the result has been found
+ */
+bool ValueIterationCache::lookup(const Key &key, std::vector<std::pair<double,unsigned int> > &values, std::vector<double> *upperBounds) {
+    bool found = false;
+    // The cache is shared between RA level probes that run in parallel
+    #pragma omp critical (valueIterationCache)
+    {
+        for (auto it = entries.begin();it!=entries.end();it++) {
+            if (it->key==key) {
+                values = it->values;
+                if (upperBounds!=NULL) *upperBounds = it->upperBounds;
+                entries.splice(entries.begin(),entries,it);
+                found = true;
+                break;
             }
         }
+        if (found) nofHits++; else nofMisses++;
+    }
+    return found;
+}
 
-        // Now build the value+action result
-        std::vector<std::pair<double,unsigned int> > result(states.size());
-        #pragma omp parallel for
-        for (unsigned int i=0;i<states.size();i++) {
-            if (touchable[i]) {
-                double bestValue = 0.0;
-                unsigned int dir = 0;
-                for (unsigned int j=0;j<transitions[i].size();j++) {
-                    auto const &a = transitions[i][j];
-                    double newValue = 0.0;
-                    for (auto &e : a.edges) {
-                        newValue += e.first*newValues[e.second];
-                    }
-                    if (newValue > bestValue) {
-                        bestValue = newValue;
-                        dir = j;
-                    }
-                }
-                result[i] = std::pair<double,unsigned int>(std::nextafter(bestValue,0.0),dir);
+/**
+ * @brief Stores a value iteration result in the cache and drops the least recently used results if the cache is full.
+ *        An earlier result for the same problem is replaced.
+ * @param key The value iteration problem
+ * @param values The result
+ * @param upperBounds The upper bounds computed by interval iteration, or NULL
+ */
+void ValueIterationCache::insert(const Key &key, const std::vector<std::pair<double,unsigned int> > &values, const std::vector<double> *upperBounds) {
+    Entry entry;
+    entry.key = key;
+    entry.values = values;
+    if (upperBounds!=NULL) entry.upperBounds = *upperBounds;
+    if (entry.sizeInBytes()>maxCachedBytes) return;
+    #pragma omp critical (valueIterationCache)
+    {
+        for (auto it = entries.begin();it!=entries.end();it++) {
+            if (it->key==key) {
+                nofCachedBytes -= it->sizeInBytes();
+                entries.erase(it);
+                break;
             }
         }
-
-        delete[] newValues;
-
-        // Now recompute all fixed-probability values
-        for (unsigned int i=0;i<states.size();i++) {
-            if (!(touchable[i])) {
-                double bestValue = 0.0;
-                unsigned int dir = 0;
-                for (unsigned int j=0;j<transitions[i].size();j++) {
-                    auto &a = transitions[i][j];
-                    double newValue = 0.0;
-                    for (auto &e : a.edges) {
-                        if (fixedValues.count(e.second)>0) {
-                            newValue += e.first*fixedValues.at(e.second);
-                        } else {
-                            newValue += e.first*result[e.second].first;
-                        }
-                    }
-                    if (newValue > bestValue) {
-                        bestValue = newValue;
-                        dir = j;
-                    }
-                }
-                result[i] = std::pair<double,unsigned int>(std::nextafter(bestValue,0.0),dir);
-            }
-            assert(result[i].second < transitions[i].size());
+        while (nofCachedBytes+entry.sizeInBytes()>maxCachedBytes) {
+            nofCachedBytes -= entries.back().sizeInBytes();
+            entries.pop_back();
         }
-
-        return result;
+        nofCachedBytes += entry.sizeInBytes();
+        entries.push_front(std::move(entry));
     }
 }
 
-
 /**
  * @brief Computes an RA policy.
  * @param raLevel The minimum requested RA level.
+ * @param settings The parameters for value iteration
+ * @param cache A cache for value iteration results that can be reused between calls with different RA levels, or NULL
+ * @param statistics If not NULL, the running times and value iteration statistics are stored here
+ * @param log If not NULL, the progress of the outer iteration is reported to it
  * @return a pair consisting of the RA quality of the strategy and the strategy itself.
  */
-std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash>,double> ParityMDP::computeRAPolicy(double raLevel, double epsilon, bool computePolicyEagerly) const {
+std::pair<Strategy,double> ParityMDP::computeRAPolicy(double raLevel, const ValueIterationSettings &settings, ValueIterationCache *cache, ProbeStatistics *statistics, std::ostream *log) const {
+    const StopWatch stopWatch;
 
     // The final strategy
-    std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash> strategy;
+    Strategy strategy(transitions.nofStates());
     unsigned int strategyMemoryUsedSoFar = 0;
 
     // Outer Loop: Iterate over the number of possible switchbacks
     unsigned int nofTargetColorSwitchbacks = 0;
-    StateSetType winningOuterGoalStates;
+    StateSet winningOuterGoalStates(transitions.nofStates());
     unsigned int oldNofWinningOuterGoalStates;
     double qualityOfGeneratedImplementation = 2.0;
     do {
-        std::cerr << "Outer iteration!\n";
+        if (log!=NULL) *log << "Outer iteration!\n";
         oldNofWinningOuterGoalStates = winningOuterGoalStates.size();
 
         // Inner Loop: Iterate over the possible goal colors
@@ -240,95 +125,165 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
 
             // Greatest fix-point over the goal states:
             // 1. Build current set of goal states
-            StateSetType currentGoalStates;
-            for (unsigned int i=0;i<states.size();i++) {
+            StateSet currentGoalStates(transitions.nofStates());
+            currentGoalStates.assignIf([this,minGoalColor](unsigned int i) {
                 unsigned int currentColor = colors[i];
-                if (((currentColor & 1)==0) && (currentColor>=minGoalColor)) {
-                    currentGoalStates.insert(i);
-                }
-            }
+                return ((currentColor & 1)==0) && (currentColor>=minGoalColor);
+            });
 
             // 3. Prepare the MDP for Value iteration
             //    This is a special MDP in which each state
             //    is copied: whenever an odd color > currentColor is
             //    visited, the run moves to the second copy. The
-            //    second copy starts in state "states.size()" (using
+            //    second copy starts in state "transitions.nofStates()" (using
             //    the numbers from the actual product MDP).
             //
             //    We need this extra analysis as when such a color
             //    is visited in the middle between the goal states,
             //    the probabilities still need to add up to raLevel,
             //    and otherwise the computation would not be right.
-            MDP mdpForAnalysis;
-            mdpForAnalysis.actions = actions;
-            mdpForAnalysis.initialState = initialState;
-            // ---> First copy of every state
-            mdpForAnalysis.states = states;
-            // ---> Second copy of every state
-            mdpForAnalysis.states.reserve(states.size()*2);
-            for (auto &s : states) {
-                mdpForAnalysis.states.push_back(MDPState(s.label));
-            }
-            // ---> First copy of every transition:
-            mdpForAnalysis.transitions.resize(mdpForAnalysis.states.size());
-            for (unsigned int i=0;i<transitions.size();i++) {
-                mdpForAnalysis.transitions[i].reserve(transitions[i].size());
-                mdpForAnalysis.transitions[i+states.size()].reserve(transitions[i].size());
-                for (unsigned int j=0;j<transitions[i].size();j++) {
-                    MDPTransition newTransA;
-                    MDPTransition newTransB;
-                    newTransA.edges.reserve(transitions[i][j].edges.size()*2);
-                    newTransB.edges.reserve(transitions[i][j].edges.size()*2);
-                    newTransA.action = transitions[i][j].action;
-                    newTransB.action = transitions[i][j].action;
-                    for (auto edge : transitions[i][j].edges) {
-                        unsigned int currentColor = colors[edge.second];
-                        if (((currentColor & 1)>0) && (currentColor>minGoalColor)) {
-                            newTransA.edges.push_back(std::pair<double,unsigned int>(edge.first,edge.second + states.size()));
-                        } else {
-                            newTransA.edges.push_back(edge);
-                        }
-                        newTransB.edges.push_back(std::pair<double,unsigned int>(edge.first,edge.second + states.size()));
-                    }
-                    mdpForAnalysis.transitions[i].push_back(newTransA);
-                    mdpForAnalysis.transitions[i+states.size()].push_back(newTransB);
+            //
+            //    The copies are not built explicitly, but the
+            //    "BackupCopyTransitions" view computes them on-the-fly.
+            const BackupCopyTransitions transitionsForAnalysis(transitions,colors,minGoalColor);
+
+            //    For topological value iteration, the SCC decomposition is computed only once
+            //    for all rounds of the fixpoint operation. It ignores the outgoing edges
+            //    of the states whose values are fixed in all rounds. The goal states cannot
+            //    be included, as they are removed over time. The same holds for the
+            //    predecessor relation used by the graph analyses in value iteration and
+            //    for reusing the results for a previous version of the MDP.
+            SCCDecomposition sccDecomposition;
+            PredecessorRelation predecessors;
+            bool graphAnalysesComputed = false;
+            auto computeGraphAnalysesIfNeeded = [&]() {
+                if (graphAnalysesComputed) return;
+                graphAnalysesComputed = true;
+                if (settings.qualitativePrecomputation || settings.intervalIteration || ((cache!=NULL) && cache->hasPreviousVersion())) {
+                    predecessors = computePredecessorRelation(transitionsForAnalysis);
                 }
-            }
+                if (settings.method!=ValueIterationSettings::TOPOLOGICAL) return;
+                std::vector<bool> permanentlyFixed(transitionsForAnalysis.nofStates());
+                for (unsigned int i=0;i<transitions.nofStates();i++) {
+                    permanentlyFixed[i] = transitionsForAnalysis.isBackupTriggering(i);
+                }
+                winningOuterGoalStates.forEach([&](unsigned int gs) {
+                    permanentlyFixed[gs] = true;
+                    permanentlyFixed[gs+transitions.nofStates()] = true;
+                });
+                sccDecomposition = computeSCCDecomposition(transitionsForAnalysis,permanentlyFixed);
+            };
+            auto setGraphAnalysisHints = [&](ValueIterationHints &hints) {
+                if (settings.method==ValueIterationSettings::TOPOLOGICAL) hints.sccDecomposition = &sccDecomposition;
+                if (settings.qualitativePrecomputation || settings.intervalIteration) hints.predecessors = &predecessors;
+            };
 
             // 2. Perform the fixpoint operation
             std::vector<std::pair<double,unsigned int> > values; // The positional final policy
+            std::vector<double> upperBounds; // Only used for interval iteration
+            std::vector<unsigned int> thresholdStates; // Only used for interval iteration
+            bool lastRoundUsedIntervalIteration = false;
+            FixedValues fixedValues(transitionsForAnalysis.nofStates());
+            ValueIterationCache::Key cacheKey;
             unsigned int oldNofInnerGoalStates = (unsigned int)-1;
             while (oldNofInnerGoalStates != currentGoalStates.size()) {
                 oldNofInnerGoalStates = currentGoalStates.size();
+                const StopWatch roundStopWatch;
+                FixpointRoundStatistics *roundStatistics = NULL;
+                if (statistics!=NULL) {
+                    statistics->rounds.push_back(FixpointRoundStatistics());
+                    roundStatistics = &(statistics->rounds.back());
+                    roundStatistics->outerIteration = nofTargetColorSwitchbacks;
+                    roundStatistics->minGoalColor = minGoalColor;
+                    roundStatistics->nofGoalStates = currentGoalStates.size();
+                }
 
                 // 2. Prepare the fixed values for value iteration
-                std::map<unsigned, double> fixedValues;
-                for (unsigned int i=0;i<states.size();i++) {
-                    unsigned int currentColor = colors[i];
-                    if (((currentColor & 1)>0) && (currentColor>minGoalColor)) {
-                        fixedValues[i] = 0.0;
+                // -> Goal states are the innermost goal states and the ones found earlier
+                fixedValues.clear();
+                #pragma omp parallel for schedule(static)
+                for (unsigned int i=0;i<transitions.nofStates();i++) {
+                    if (currentGoalStates.contains(i) || winningOuterGoalStates.contains(i)) {
+                        fixedValues.set(i,1.0);
+                    } else if (transitionsForAnalysis.isBackupTriggering(i)) {
+                        fixedValues.set(i,0.0);
                     }
+                    if (winningOuterGoalStates.contains(i)) fixedValues.set(i+transitions.nofStates(),1.0);
                 }
-                // -> Goal states are the innermost goal states....
-                for (auto gs : currentGoalStates) {
-                    fixedValues[gs] = 1.0;
+
+                // 3. Perform Value iteration - or take the result from the cache
+                // Removing goal states can only lower the values. With interval iteration, the upper
+                // bounds of the previous round are hence upper bounds in this round, too, and value
+                // iteration continues from them. The interval iteration also decides early which goal
+                // states have values below the RA level. Otherwise, the result of the previous round
+                // can be used as starting point from above if requested. Value iteration ignores it if
+                // the states that it updates contain an end component, as the values then do not
+                // converge to the right ones from above. As value iteration otherwise stops
+                // before it has converged, the values can be slightly too high, so this is not done by
+                // default. It is also not done when computing the policy eagerly, as the eagerly computed
+                // policy is only guaranteed to make progress towards the goal states if the values
+                // increase during the iteration.
+                const bool warmStart = settings.warmStart && !settings.intervalIteration && (values.size()>0) && !settings.computePolicyEagerly;
+                lastRoundUsedIntervalIteration = settings.intervalIteration;
+                std::vector<std::pair<double,unsigned int> > cachedValues;
+                std::vector<double> previousUpperBounds;
+                previousUpperBounds.swap(upperBounds);
+                bool cacheHit = false;
+                if (cache!=NULL) {
+                    cacheKey = makeValueIterationCacheKey(minGoalColor,currentGoalStates,winningOuterGoalStates,settings);
+                    cacheHit = cache->lookup(cacheKey,cachedValues,&upperBounds);
                 }
-                // ... and the ones found earlier...
-                for (auto gs : winningOuterGoalStates) {
-                    fixedValues[gs] = 1.0;
-                    fixedValues[gs+states.size()] = 1.0;
+                if (roundStatistics!=NULL) roundStatistics->cacheHit = cacheHit;
+                if (cacheHit && upperBounds.empty()) {
+                    values.swap(cachedValues);
+                    lastRoundUsedIntervalIteration = false;
+                } else {
+                    computeGraphAnalysesIfNeeded();
+                    ValueIterationSettings roundSettings = settings;
+                    roundSettings.intervalIteration = lastRoundUsedIntervalIteration;
+                    ValueIterationHints hints;
+                    setGraphAnalysisHints(hints);
+                    if (roundStatistics!=NULL) {
+                        roundStatistics->valueIterations.push_back(ValueIterationStatistics());
+                        hints.statistics = &(roundStatistics->valueIterations.back());
+                    }
+                    if (lastRoundUsedIntervalIteration) {
+                        // A cached result with upper bounds may have been computed for another RA level, so
+                        // we continue from its bounds.
+                        if (cacheHit) {
+                            hints.initialValues = &cachedValues;
+                        } else {
+                            upperBounds.swap(previousUpperBounds);
+                        }
+                        hints.upperBounds = &upperBounds;
+                        thresholdStates = currentGoalStates.toVector();
+                        hints.thresholdStates = &thresholdStates;
+                        hints.threshold = raLevel;
+                    } else if (warmStart) {
+                        hints.initialValues = cacheHit?&cachedValues:&values;
+                        hints.initialValuesAreUpperBounds = true;
+                    }
+                    // After a change of the MDP, only the states whose values may have changed are updated.
+                    // Their previous values may be too high for the new version, so they are not used as
+                    // starting point - otherwise, value iteration could stop with values that are too high.
+                    std::vector<std::pair<double,unsigned int> > previousValues;
+                    std::vector<char> differingStates;
+                    std::vector<unsigned int> unaffectedStates;
+                    if (!lastRoundUsedIntervalIteration && (cache!=NULL) && cache->lookupPreviousVersion(cacheKey,previousValues,differingStates)) {
+                        unaffectedStates = fixValuesOfUnaffectedStates(predecessors,previousValues,differingStates,fixedValues);
+                    }
+                    values = performValueIteration(transitionsForAnalysis,fixedValues,roundSettings,hints);
+                    for (unsigned int state : unaffectedStates) values[state] = previousValues[state];
+                    if (cache!=NULL) cache->insert(cacheKey,values,lastRoundUsedIntervalIteration?&upperBounds:NULL);
                 }
-
-                // 3. Perform Value iteration
-                values = mdpForAnalysis.valueIteration(fixedValues,epsilon,computePolicyEagerly);
-                assert(values.size()==states.size()*2);
+                assert(values.size()==transitions.nofStates()*2);
 
                 // Debugging: Print
                 /* std::cerr << "Results of value iteration for minGoalColor:" << minGoalColor << std::endl;
-                for (unsigned int i=0;i<states.size();i++) {
+                for (unsigned int i=0;i<transitions.nofStates();i++) {
                     std::cerr << "- (";
                     bool first = true;
-                    for (auto a : states[i].label) {
+                    for (auto a : stateLabel(i)) {
                         if (first) {
                             first = false;
                         } else {
@@ -340,34 +295,53 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
                 }*/
 
                 // Update set of goal state that are reachable under the raLevel
-                for (auto it = currentGoalStates.begin(); it != currentGoalStates.end();){
-                    if (values[*it].first<raLevel)
-                        currentGoalStates.erase(it++);
-                    else
-                        ++it;
+                currentGoalStates.eraseIf([&values,raLevel](unsigned int gs) { return values[gs].first<raLevel; });
+                if (roundStatistics!=NULL) {
+                    roundStatistics->wallSeconds = roundStopWatch.wallSeconds();
+                    roundStatistics->cpuSeconds = roundStopWatch.cpuSeconds();
+                }
+            }
+
+            // With interval iteration, value iteration may have stopped early in the last round, as all goal
+            // states were known to have values of at least raLevel. The policy is computed from the values, so
+            // value iteration is continued from the last bounds until it has converged.
+            if (lastRoundUsedIntervalIteration) {
+                ValueIterationHints hints;
+                setGraphAnalysisHints(hints);
+                if (statistics!=NULL) {
+                    statistics->rounds.back().valueIterations.push_back(ValueIterationStatistics());
+                    hints.statistics = &(statistics->rounds.back().valueIterations.back());
+                }
+                hints.initialValues = &values;
+                hints.upperBounds = &upperBounds;
+                values = performValueIteration(transitionsForAnalysis,fixedValues,settings,hints);
+                if (cache!=NULL) cache->insert(cacheKey,values,&upperBounds);
+                if (statistics!=NULL) {
+                    // Counted as part of the last round
+                    statistics->rounds.back().wallSeconds += hints.statistics->wallSeconds;
+                    statistics->rounds.back().cpuSeconds += hints.statistics->cpuSeconds;
                 }
             }
 
             // Update the strategy
             {
-                std::list<unsigned int> todoNonBackup; // States in the mdpForAnalysis
-                uint64_t *doneNonBackup = new uint64_t[(states.size()+63)/64];
-                memset(doneNonBackup,0,((states.size()+63)/64)*8);
+                std::list<unsigned int> todoNonBackup; // States in transitionsForAnalysis
+                uint64_t *doneNonBackup = new uint64_t[(transitions.nofStates()+63)/64];
+                memset(doneNonBackup,0,((transitions.nofStates()+63)/64)*8);
 
                 // Fill todo list
-                for (auto it = currentGoalStates.begin(); it != currentGoalStates.end();it++ ){
-                    auto key = StrategyTransitionPredecessor(*it,0);
-                    if (strategy.count(key)==0) {
-                        todoNonBackup.push_back(*it);
-                        doneNonBackup[*it/64] |= ((uint64_t)1 << (*it % 64));
-                        qualityOfGeneratedImplementation = std::min(qualityOfGeneratedImplementation,values[*it].first);
+                currentGoalStates.forEach([&](unsigned int gs) {
+                    if (!strategy.hasInitialDataEntry(gs)) {
+                        todoNonBackup.push_back(gs);
+                        doneNonBackup[gs/64] |= ((uint64_t)1 << (gs % 64));
+                        qualityOfGeneratedImplementation = std::min(qualityOfGeneratedImplementation,values[gs].first);
                     }
-                }
+                });
 
                 // Add new parts to the strategy: First, the non-backup motion
                 std::list<unsigned int> todoBackup;
-                uint64_t *doneBackup = new uint64_t[(mdpForAnalysis.states.size()+63)/64];
-                memset(doneBackup,0,((mdpForAnalysis.states.size()+63)/64)*8);
+                uint64_t *doneBackup = new uint64_t[(transitionsForAnalysis.nofStates()+63)/64];
+                memset(doneBackup,0,((transitionsForAnalysis.nofStates()+63)/64)*8);
                 strategyMemoryUsedSoFar++;
                 while (todoNonBackup.size()>0) {
 
@@ -375,34 +349,35 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
                     unsigned int thisOne = todoNonBackup.front();
                     todoNonBackup.pop_front();
 
-                    unsigned int srcData = currentGoalStates.count(thisOne)>0?0:strategyMemoryUsedSoFar;
+                    unsigned int srcData = currentGoalStates.contains(thisOne)?0:strategyMemoryUsedSoFar;
                     unsigned int chosenTransition = values[thisOne].second;
                     // std::cerr << "ChosenTransition: " << chosenTransition << std::endl;
-                    std::map<unsigned int, unsigned int> newData;
                     if (values[thisOne].first!=0.0) { // Exact comparison with 0.0 is OK here.
-                        for (auto &e : mdpForAnalysis.transitions[thisOne].at(chosenTransition).edges) {
-                            const unsigned int dest = e.second;
-                            // std::cerr << "ISGOALSTATE: " << currentGoalStates.count(dest) << std::endl;
-                            if (currentGoalStates.count(dest)>0) {
-                                newData[dest] = 0;
-                            } else if (dest >= states.size()) {
+                        const unsigned int choice = transitionsForAnalysis.choiceBegin(thisOne)+chosenTransition;
+                        assert(chosenTransition<transitionsForAnalysis.nofChoices(thisOne));
+                        // std::cerr << "Setting Strategy transitions for " << thisOne << " " << srcData << " non-backup.\n";
+                        strategy.addEntry(thisOne,srcData,chosenTransition);
+                        for (unsigned int k=transitionsForAnalysis.edgeBegin(choice);k<transitionsForAnalysis.edgeEnd(choice);k++) {
+                            const unsigned int dest = transitionsForAnalysis.target(thisOne,k);
+                            // std::cerr << "ISGOALSTATE: " << currentGoalStates.contains(dest) << std::endl;
+                            if ((dest<transitions.nofStates()) && currentGoalStates.contains(dest)) {
+                                strategy.addMemoryUpdate(dest,0);
+                            } else if (dest >= transitions.nofStates()) {
                                 // Backup
-                                newData[dest % states.size()] = strategyMemoryUsedSoFar +1;
+                                strategy.addMemoryUpdate(dest % transitions.nofStates(),strategyMemoryUsedSoFar+1);
                                 if ((doneBackup[dest/64] & ((uint64_t)1 << (dest % 64)))==0) {
                                     todoBackup.push_back(dest);
                                     doneBackup[dest/64] |= ((uint64_t)1 << (dest % 64));
                                 }
                             } else {
-                                newData[dest] = strategyMemoryUsedSoFar;
+                                strategy.addMemoryUpdate(dest,strategyMemoryUsedSoFar);
                                 if ((doneNonBackup[dest/64] & ((uint64_t)1 << (dest % 64)))==0) {
                                     todoNonBackup.push_back(dest);
                                     doneNonBackup[dest/64] |= ((uint64_t)1 << (dest % 64));
                                 }
                             }
                         }
-                        // std::cerr << "Setting Strategy transitions for " << thisOne << " " << srcData << " non-backup.\n";
-                        StrategyTransitionPredecessor alpha(thisOne,srcData);
-                        strategy[alpha] = StrategyTransitionChoice(chosenTransition,newData);
+                        strategy.finishEntry();
                     }
                 }
 
@@ -415,14 +390,16 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
 
                     if (values[thisOne].first!=0.0) { // Exact comparison with 0.0 is OK here.
                         const unsigned int chosenTransition = values[thisOne].second;
-                        std::map<unsigned int, unsigned int> newData;
-                        for (auto &e : mdpForAnalysis.transitions[thisOne][chosenTransition].edges) {
-                            unsigned int dest = e.second;
-                            if (currentGoalStates.count(dest % states.size())>0) {
-                                newData[dest % states.size()] = 0;
-                            } else if (dest >= states.size()) {
+                        const unsigned int choice = transitionsForAnalysis.choiceBegin(thisOne)+chosenTransition;
+                        // std::cerr << "Setting Strategy transitions for " << thisOne % transitions.nofStates() << " " << strategyMemoryUsedSoFar << " backup.\n";
+                        strategy.addEntry(thisOne % transitions.nofStates(),strategyMemoryUsedSoFar,chosenTransition);
+                        for (unsigned int k=transitionsForAnalysis.edgeBegin(choice);k<transitionsForAnalysis.edgeEnd(choice);k++) {
+                            unsigned int dest = transitionsForAnalysis.target(thisOne,k);
+                            if (currentGoalStates.contains(dest % transitions.nofStates())) {
+                                strategy.addMemoryUpdate(dest % transitions.nofStates(),0);
+                            } else if (dest >= transitions.nofStates()) {
                                 // Backup
-                                newData[dest % states.size()] = strategyMemoryUsedSoFar;
+                                strategy.addMemoryUpdate(dest % transitions.nofStates(),strategyMemoryUsedSoFar);
                                 if ((doneBackup[dest/64] & ((uint64_t)1 << (dest % 64)))==0) {
                                     todoBackup.push_back(dest);
                                     doneBackup[dest/64] |= ((uint64_t)1 << (dest % 64));
@@ -431,8 +408,7 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
                                 throw "Internal error in the MDP-for-Analysis";
                             }
                         }
-                        // std::cerr << "Setting Strategy transitions for " << thisOne % states.size() << " " << strategyMemoryUsedSoFar << " backup.\n";
-                        strategy[StrategyTransitionPredecessor(thisOne % states.size(),strategyMemoryUsedSoFar)] = StrategyTransitionChoice(chosenTransition,newData);
+                        strategy.finishEntry();
                     }
                 }
 
@@ -441,51 +417,65 @@ std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionCho
             }
 
             // Add all newly found goal states.
-            winningOuterGoalStates.insert(currentGoalStates.begin(),currentGoalStates.end());
+            winningOuterGoalStates.insertAll(currentGoalStates);
         }
 
         nofTargetColorSwitchbacks++;
     } while (winningOuterGoalStates.size()!=oldNofWinningOuterGoalStates);
 
     // Compute outer strategy towards the goal states
-    MDP mdpForAnalysis;
-    mdpForAnalysis.actions = actions;
-    mdpForAnalysis.initialState = initialState;
-    mdpForAnalysis.states = states;
-    mdpForAnalysis.transitions = transitions;
-    std::map<unsigned, double> fixedValues;
-    for (auto a : winningOuterGoalStates) {
-        fixedValues[a] = 1.0;
+    FixedValues fixedValues(transitions.nofStates());
+    winningOuterGoalStates.forEach([&fixedValues](unsigned int gs) { fixedValues.set(gs,1.0); });
+    std::vector<std::pair<double,unsigned int> > values;
+    ValueIterationCache::Key cacheKey;
+    if (cache!=NULL) {
+        cacheKey = makeValueIterationCacheKey((unsigned int)-1,StateSet(),winningOuterGoalStates,settings);
+    }
+    if ((cache==NULL) || !(cache->lookup(cacheKey,values))) {
+        ValueIterationHints hints;
+        if (statistics!=NULL) {
+            statistics->finalValueIterations.push_back(ValueIterationStatistics());
+            hints.statistics = &(statistics->finalValueIterations.back());
+        }
+        std::vector<std::pair<double,unsigned int> > previousValues;
+        std::vector<char> differingStates;
+        std::vector<unsigned int> unaffectedStates;
+        PredecessorRelation predecessors;
+        if ((cache!=NULL) && cache->lookupPreviousVersion(cacheKey,previousValues,differingStates)) {
+            predecessors = computePredecessorRelation(transitions);
+            unaffectedStates = fixValuesOfUnaffectedStates(predecessors,previousValues,differingStates,fixedValues);
+            hints.predecessors = &predecessors;
+        }
+        values = performValueIteration(transitions,fixedValues,settings,hints);
+        for (unsigned int state : unaffectedStates) values[state] = previousValues[state];
+        if (cache!=NULL) cache->insert(cacheKey,values);
     }
-    std::vector<std::pair<double,unsigned int> > values = mdpForAnalysis.valueIteration(fixedValues,epsilon,computePolicyEagerly);
     qualityOfGeneratedImplementation = std::min(qualityOfGeneratedImplementation,values[initialState].first);
-    for (unsigned int i=0;i<states.size();i++) {
+    for (unsigned int i=0;i<transitions.nofStates();i++) {
         /* if (values[i].first>=raLevel) */ {
-            auto key = StrategyTransitionPredecessor(i,0);
-            if (strategy.count(key)==0) {
+            if (!strategy.hasInitialDataEntry(i)) {
                 if (values[i].first!=0.0) { // Exact comparison with 0.0 is OK here.
                     // std::cerr << "Processing " << i << std::endl;
-                    std::map<unsigned int, unsigned int> newData;
                     unsigned int chosenTransition = values[i].second;
-                    for (auto &e : mdpForAnalysis.transitions[i][chosenTransition].edges) {
-                        unsigned int dest = e.second;
-                        newData[dest] = 0;
+                    const unsigned int choice = transitions.choiceBegin(i)+chosenTransition;
+                    strategy.addEntry(i,0,chosenTransition);
+                    for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+                        unsigned int dest = transitions.targets[k];
+                        strategy.addMemoryUpdate(dest,0);
                     }
-                    strategy[key] = StrategyTransitionChoice(chosenTransition,newData);
+                    strategy.finishEntry();
                 }
             }
         }
     }
 
-    return std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash>,double>(strategy,qualityOfGeneratedImplementation);
-}
-
-void ParityMDP::printPolicy(const std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash> &policy) const {
-    std::cout << policy.size() << "\n";
-    for (auto &entry : policy) {
-        std::cout << entry.first.mdpState << " " << entry.first.dataState << " " << toNonParityMDPMapper.at(entry.first.mdpState) << " " << entry.second.action << "\n";
-        for (auto &entry2 : entry.second.memoryUpdate) {
-            std::cout << "-> " << toNonParityMDPMapper.at(entry2.first) << " " << entry2.first << " " << entry2.second << "\n";
-        }
+    strategy.finalize();
+    if (statistics!=NULL) {
+        statistics->raLevel = raLevel;
+        statistics->quality = qualityOfGeneratedImplementation;
+        statistics->wallSeconds = stopWatch.wallSeconds();
+        statistics->cpuSeconds = stopWatch.cpuSeconds();
+        statistics->nofOuterIterations = nofTargetColorSwitchbacks;
     }
+    return std::pair<Strategy,double>(std::move(strategy),qualityOfGeneratedImplementation);
 }
@@ -0,0 +1,394 @@
+#ifndef __DISTRIBUTED_VALUE_ITERATION_HPP____
+#define __DISTRIBUTED_VALUE_ITERATION_HPP____
+
+#ifdef USE_MPI
+
+#include <mpi.h>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+//=====================================================
+// Distributed value iteration
+//
+// Only the first MPI process ("root") reads the MDP,
+// builds the product and searches for the policy. For
+// every value iteration call with the DISTRIBUTED
+// method, it splits the states into slices and sends
+// every other process only the transitions of its
+// slice. These processes wait for such problems in
+// "runDistributedValueIterationWorker" until the root
+// process stops them.
+//=====================================================
+
+/**
+ * @brief The part of a value iteration problem that one MPI process works on. The states are numbered locally: the
+ *        states of the slice come first, followed by the "halo" states of other slices that they have transitions
+ *        to. The values of halo states that value iteration updates are received from their owners after every
+ *        sweep, and the values of the other halo states are constant. The choices of slice state i are
+ *        stateOffsets[i] to stateOffsets[i+1]-1 (none if it is not updated), and the edges of choice j are
+ *        choiceOffsets[j] to choiceOffsets[j+1]-1. The values sent to process p are the ones of the slice states
+ *        sendStates[sendOffsets[p]] to sendStates[sendOffsets[p]+sendCounts[p]-1], and likewise for the halo values
+ *        received from process p.
+ */
+struct DistributedSlice {
+    unsigned int nofSliceStates;
+    std::vector<char> touchable; // For the slice states
+    std::vector<unsigned int> stateOffsets;
+    std::vector<unsigned int> choiceOffsets;
+    std::vector<double> probabilities;
+    std::vector<unsigned int> targets;
+    std::vector<double> values; // For the slice states and the halo states
+    std::vector<unsigned int> policy; // For the slice states, only with eager policy computation
+    std::vector<int> sendCounts;
+    std::vector<int> sendOffsets;
+    std::vector<unsigned int> sendStates;
+    std::vector<int> receiveCounts;
+    std::vector<int> receiveOffsets;
+    std::vector<unsigned int> receiveStates;
+    DistributedSlice() : nofSliceStates(0) {}
+};
+
+/**
+ * @brief The settings of a value iteration call that the worker processes need
+ */
+struct DistributedValueIterationParameters {
+    double epsilon;
+    int computePolicyEagerly;
+    int initialValuesAreUpperBounds;
+};
+
+static const int distributedValueIterationStopCommand = 0;
+static const int distributedValueIterationSolveCommand = 1;
+
+/**
+ * @brief Sends a vector to another process, in chunks that fit into the element counts of MPI
+ */
+template<class T> void sendVector(const std::vector<T> &data, int process) {
+    uint64_t size = data.size();
+    MPI_Send(&size,1,MPI_UINT64_T,process,0,MPI_COMM_WORLD);
+    const uint64_t maxChunkSize = (1u<<30)/sizeof(T);
+    for (uint64_t pos=0;pos<size;pos+=maxChunkSize) {
+        const uint64_t chunkSize = std::min(maxChunkSize,size-pos);
+        MPI_Send(data.data()+pos,(int)(chunkSize*sizeof(T)),MPI_BYTE,process,0,MPI_COMM_WORLD);
+    }
+}
+
+/**
+ * @brief Receives a vector sent by "sendVector" from the root process
+ */
+template<class T> void receiveVector(std::vector<T> &data) {
+    uint64_t size;
+    MPI_Recv(&size,1,MPI_UINT64_T,0,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+    data.resize(size);
+    const uint64_t maxChunkSize = (1u<<30)/sizeof(T);
+    for (uint64_t pos=0;pos<size;pos+=maxChunkSize) {
+        const uint64_t chunkSize = std::min(maxChunkSize,size-pos);
+        MPI_Recv(data.data()+pos,(int)(chunkSize*sizeof(T)),MPI_BYTE,0,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+    }
+}
+
+/**
+ * @brief Splits the states of a value iteration problem into contiguous slices, one for every MPI process, such
+ *        that all slices have about the same number of edges of states that value iteration updates. Sends every
+ *        other process its slice (see "receiveDistributedSlice") and returns the slice of the root process. Is
+ *        only called by the root process, after "startDistributedValueIteration".
+ * @param transitions The transition relation - can be any class offering the interface of a "TransitionMatrix"
+ * @param touchable The states that value iteration updates
+ * @param values The initial values of all states
+ * @param policy The initial policy of all states, or NULL if the policy is not computed eagerly
+ * @param sliceBegins Is set to the first state of every slice, followed by the number of states
+ * @return the slice of the root process
+ */
+template<class Transitions> DistributedSlice distributeValueIterationProblem(const Transitions &transitions, const std::vector<bool> &touchable, const double *values, const unsigned int *policy, std::vector<unsigned int> &sliceBegins) {
+    const unsigned int nofStates = transitions.nofStates();
+    int nofProcesses;
+    MPI_Comm_size(MPI_COMM_WORLD,&nofProcesses);
+
+    // Every state counts with its number of edges plus one, so that states without updates are distributed, too
+    auto stateWeight = [&](unsigned int state) -> uint64_t {
+        if (!touchable[state]) return 1;
+        return 1+transitions.edgeBegin(transitions.choiceEnd(state))-transitions.edgeBegin(transitions.choiceBegin(state));
+    };
+    uint64_t totalWeight = 0;
+    for (unsigned int i=0;i<nofStates;i++) totalWeight += stateWeight(i);
+    sliceBegins.assign(nofProcesses+1,nofStates);
+    sliceBegins[0] = 0;
+    uint64_t weightSoFar = 0;
+    int nextSlice = 1;
+    for (unsigned int i=0;(i<nofStates) && (nextSlice<nofProcesses);i++) {
+        while ((nextSlice<nofProcesses) && (weightSoFar>=totalWeight*nextSlice/nofProcesses)) sliceBegins[nextSlice++] = i;
+        weightSoFar += stateWeight(i);
+    }
+    auto owner = [&sliceBegins](unsigned int state) -> int {
+        return std::upper_bound(sliceBegins.begin(),sliceBegins.end(),state)-sliceBegins.begin()-1;
+    };
+
+    // The halo states of every slice, ordered by their state numbers. Only the values of states that value
+    // iteration updates need to be exchanged.
+    std::vector<unsigned int> localNumbers(nofStates,(unsigned int)-1);
+    std::vector<std::vector<unsigned int> > haloStates(nofProcesses);
+    for (int p=0;p<nofProcesses;p++) {
+        for (unsigned int i=sliceBegins[p];i<sliceBegins[p+1];i++) {
+            if (!touchable[i]) continue;
+            for (unsigned int k=transitions.edgeBegin(transitions.choiceBegin(i));k<transitions.edgeBegin(transitions.choiceEnd(i));k++) {
+                const unsigned int target = transitions.target(i,k);
+                if (((target<sliceBegins[p]) || (target>=sliceBegins[p+1])) && (localNumbers[target]!=(unsigned int)p)) {
+                    localNumbers[target] = p;
+                    haloStates[p].push_back(target);
+                }
+            }
+        }
+        std::sort(haloStates[p].begin(),haloStates[p].end());
+    }
+
+    // The values to send: As the halo states are ordered, the values that process p sends to process q are in the
+    // same order as the ones that q receives from p.
+    std::vector<std::vector<unsigned int> > sendStates(nofProcesses);
+    std::vector<std::vector<int> > sendCounts(nofProcesses,std::vector<int>(nofProcesses,0));
+    for (int q=0;q<nofProcesses;q++) {
+        for (unsigned int state : haloStates[q]) {
+            if (!touchable[state]) continue;
+            const int p = owner(state);
+            sendStates[p].push_back(state-sliceBegins[p]);
+            sendCounts[p][q]++;
+        }
+    }
+
+    // Build the slices, and send them to the other processes one after the other
+    DistributedSlice rootSlice;
+    for (int p=nofProcesses-1;p>=0;p--) {
+        DistributedSlice slice;
+        const unsigned int sliceBegin = sliceBegins[p];
+        const unsigned int sliceEnd = sliceBegins[p+1];
+        slice.nofSliceStates = sliceEnd-sliceBegin;
+        for (unsigned int i=sliceBegin;i<sliceEnd;i++) localNumbers[i] = i-sliceBegin;
+        for (unsigned int k=0;k<haloStates[p].size();k++) localNumbers[haloStates[p][k]] = slice.nofSliceStates+k;
+
+        slice.stateOffsets.push_back(0);
+        slice.choiceOffsets.push_back(0);
+        for (unsigned int i=sliceBegin;i<sliceEnd;i++) {
+            slice.touchable.push_back(touchable[i]);
+            if (touchable[i]) {
+                for (unsigned int j=0;j<transitions.nofChoices(i);j++) {
+                    const unsigned int choice = transitions.choiceBegin(i)+j;
+                    for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+                        slice.probabilities.push_back(transitions.probability(k));
+                        slice.targets.push_back(localNumbers[transitions.target(i,k)]);
+                    }
+                    slice.choiceOffsets.push_back(slice.targets.size());
+                }
+            }
+            slice.stateOffsets.push_back(slice.choiceOffsets.size()-1);
+        }
+        slice.values.assign(values+sliceBegin,values+sliceEnd);
+        for (unsigned int state : haloStates[p]) slice.values.push_back(values[state]);
+        if (policy!=NULL) slice.policy.assign(policy+sliceBegin,policy+sliceEnd);
+
+        slice.sendCounts = sendCounts[p];
+        slice.sendOffsets.assign(nofProcesses,0);
+        for (int q=1;q<nofProcesses;q++) slice.sendOffsets[q] = slice.sendOffsets[q-1]+slice.sendCounts[q-1];
+        slice.sendStates.swap(sendStates[p]);
+        slice.receiveCounts.assign(nofProcesses,0);
+        for (unsigned int state : haloStates[p]) {
+            if (!touchable[state]) continue;
+            slice.receiveCounts[owner(state)]++;
+            slice.receiveStates.push_back(localNumbers[state]);
+        }
+        slice.receiveOffsets.assign(nofProcesses,0);
+        for (int q=1;q<nofProcesses;q++) slice.receiveOffsets[q] = slice.receiveOffsets[q-1]+slice.receiveCounts[q-1];
+        std::vector<unsigned int>().swap(haloStates[p]);
+
+        if (p==0) {
+            rootSlice = std::move(slice);
+        } else {
+            sendVector(slice.touchable,p);
+            sendVector(slice.stateOffsets,p);
+            sendVector(slice.choiceOffsets,p);
+            sendVector(slice.probabilities,p);
+            sendVector(slice.targets,p);
+            sendVector(slice.values,p);
+            sendVector(slice.policy,p);
+            sendVector(slice.sendCounts,p);
+            sendVector(slice.sendOffsets,p);
+            sendVector(slice.sendStates,p);
+            sendVector(slice.receiveCounts,p);
+            sendVector(slice.receiveOffsets,p);
+            sendVector(slice.receiveStates,p);
+        }
+    }
+    return rootSlice;
+}
+
+/**
+ * @brief Receives the slice of this process sent by "distributeValueIterationProblem"
+ */
+inline DistributedSlice receiveDistributedSlice() {
+    DistributedSlice slice;
+    receiveVector(slice.touchable);
+    receiveVector(slice.stateOffsets);
+    receiveVector(slice.choiceOffsets);
+    receiveVector(slice.probabilities);
+    receiveVector(slice.targets);
+    receiveVector(slice.values);
+    receiveVector(slice.policy);
+    receiveVector(slice.sendCounts);
+    receiveVector(slice.sendOffsets);
+    receiveVector(slice.sendStates);
+    receiveVector(slice.receiveCounts);
+    receiveVector(slice.receiveOffsets);
+    receiveVector(slice.receiveStates);
+    slice.nofSliceStates = slice.touchable.size();
+    return slice;
+}
+
+/**
+ * @brief Sends the values of the slice states that other processes depend on to these processes, and receives the
+ *        values of the halo states that value iteration updates from their owners
+ * @param slice The slice of this process
+ */
+inline void exchangeHaloValues(DistributedSlice &slice) {
+    std::vector<double> sendBuffer(slice.sendStates.size());
+    std::vector<double> receiveBuffer(slice.receiveStates.size());
+    for (unsigned int i=0;i<slice.sendStates.size();i++) sendBuffer[i] = slice.values[slice.sendStates[i]];
+    MPI_Alltoallv(sendBuffer.data(),slice.sendCounts.data(),slice.sendOffsets.data(),MPI_DOUBLE,
+                  receiveBuffer.data(),slice.receiveCounts.data(),slice.receiveOffsets.data(),MPI_DOUBLE,MPI_COMM_WORLD);
+    for (unsigned int i=0;i<slice.receiveStates.size();i++) slice.values[slice.receiveStates[i]] = receiveBuffer[i];
+}
+
+/**
+ * @brief Performs value iteration on the slice of this process, together with all other processes. The slice states
+ *        are updated in place as by the UNSYNCHRONIZED method of "performValueIteration", and value iteration stops
+ *        once the sum of the value changes over all processes in a sweep is at most epsilon.
+ * @param slice The slice of this process
+ * @param parameters The settings of the value iteration call
+ * @param finalResidual Is set to the sum of the value changes in the last sweep
+ * @return The number of sweeps
+ */
+inline unsigned int solveDistributedSlice(DistributedSlice &slice, const DistributedValueIterationParameters &parameters, double &finalResidual) {
+    double *values = slice.values.data();
+    unsigned int nofSweeps = 0;
+    bool terminated = false;
+    while (!terminated) {
+        double diff = 0.0;
+        #pragma omp parallel for reduction (+:diff)
+        for (unsigned int i=0;i<slice.nofSliceStates;i++) {
+            if (!slice.touchable[i]) continue;
+            double bestValue = 0.0;
+            unsigned int bestDirection = (unsigned int)-1;
+            for (unsigned int j=slice.stateOffsets[i];j<slice.stateOffsets[i+1];j++) {
+                double newValue = 0.0;
+                for (unsigned int k=slice.choiceOffsets[j];k<slice.choiceOffsets[j+1];k++) {
+                    newValue += slice.probabilities[k]*values[slice.targets[k]];
+                }
+                if (newValue > bestValue) {
+                    bestValue = newValue;
+                    bestDirection = j-slice.stateOffsets[i];
+                }
+            }
+            // The same update as in "performValueIteration"
+            if (parameters.computePolicyEagerly) {
+                if (parameters.initialValuesAreUpperBounds?(bestValue < values[i]):(bestValue > values[i])) {
+                    diff += std::abs(bestValue - values[i]);
+                    values[i] = bestValue;
+                    if (bestDirection!=(unsigned int)-1) slice.policy[i] = bestDirection;
+                }
+            } else {
+                diff += std::abs(bestValue - values[i]);
+                values[i] = std::nextafter(bestValue,0.0);
+            }
+        }
+        double totalDiff;
+        MPI_Allreduce(&diff,&totalDiff,1,MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+        exchangeHaloValues(slice);
+        nofSweeps++;
+        finalResidual = totalDiff;
+        terminated = totalDiff <= parameters.epsilon;
+    }
+    return nofSweeps;
+}
+
+/**
+ * @brief Collects the values (and the policy) of the slice states of all processes in the root process
+ * @param slice The slice of this process
+ * @param parameters The settings of the value iteration call, which decide on all processes alike whether the policy
+ *        is collected, as slices without states have no policy entries either
+ * @param sliceBegins The first state of every slice, followed by the number of states (only used by the root process)
+ * @param values The values of all states (only used by the root process)
+ * @param policy The policy of all states, or NULL if the policy is not computed eagerly (only used by the root process)
+ */
+inline void gatherSliceResults(const DistributedSlice &slice, const DistributedValueIterationParameters &parameters, const std::vector<unsigned int> &sliceBegins, double *values, unsigned int *policy) {
+    std::vector<int> counts;
+    std::vector<int> offsets;
+    for (unsigned int p=0;p+1<sliceBegins.size();p++) {
+        counts.push_back(sliceBegins[p+1]-sliceBegins[p]);
+        offsets.push_back(sliceBegins[p]);
+    }
+    MPI_Gatherv(slice.values.data(),slice.nofSliceStates,MPI_DOUBLE,values,counts.data(),offsets.data(),MPI_DOUBLE,0,MPI_COMM_WORLD);
+    if (parameters.computePolicyEagerly) {
+        MPI_Gatherv(slice.policy.data(),slice.nofSliceStates,MPI_UNSIGNED,policy,counts.data(),offsets.data(),MPI_UNSIGNED,0,MPI_COMM_WORLD);
+    }
+}
+
+/**
+ * @brief Lets the worker processes wait for a new value iteration problem. Is only called by the root process.
+ * @param parameters The settings of the value iteration call
+ */
+inline void startDistributedValueIteration(DistributedValueIterationParameters parameters) {
+    int command = distributedValueIterationSolveCommand;
+    MPI_Bcast(&command,1,MPI_INT,0,MPI_COMM_WORLD);
+    MPI_Bcast(&parameters.epsilon,1,MPI_DOUBLE,0,MPI_COMM_WORLD);
+    MPI_Bcast(&parameters.computePolicyEagerly,1,MPI_INT,0,MPI_COMM_WORLD);
+    MPI_Bcast(&parameters.initialValuesAreUpperBounds,1,MPI_INT,0,MPI_COMM_WORLD);
+}
+
+/**
+ * @brief The main loop of the processes other than the root process: Solves the slices of the value iteration
+ *        problems sent by the root process until it stops the workers.
+ */
+inline void runDistributedValueIterationWorker() {
+    while (true) {
+        int command;
+        MPI_Bcast(&command,1,MPI_INT,0,MPI_COMM_WORLD);
+        if (command!=distributedValueIterationSolveCommand) return;
+        DistributedValueIterationParameters parameters;
+        MPI_Bcast(&parameters.epsilon,1,MPI_DOUBLE,0,MPI_COMM_WORLD);
+        MPI_Bcast(&parameters.computePolicyEagerly,1,MPI_INT,0,MPI_COMM_WORLD);
+        MPI_Bcast(&parameters.initialValuesAreUpperBounds,1,MPI_INT,0,MPI_COMM_WORLD);
+        DistributedSlice slice = receiveDistributedSlice();
+        double finalResidual;
+        solveDistributedSlice(slice,parameters,finalResidual);
+        gatherSliceResults(slice,parameters,std::vector<unsigned int>(),NULL,NULL);
+    }
+}
+
+/**
+ * @brief Initializes MPI for the lifetime of the object. Only the main thread makes MPI calls. When the object of
+ *        the root process is destroyed, it stops the worker processes.
+ */
+class MPIEnvironment {
+private:
+    int rank;
+    int nofProcesses;
+public:
+    MPIEnvironment(int *nofArgs, char ***args) {
+        int provided;
+        MPI_Init_thread(nofArgs,args,MPI_THREAD_FUNNELED,&provided);
+        MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+        MPI_Comm_size(MPI_COMM_WORLD,&nofProcesses);
+    }
+    ~MPIEnvironment() {
+        if (isRoot()) {
+            int command = distributedValueIterationStopCommand;
+            MPI_Bcast(&command,1,MPI_INT,0,MPI_COMM_WORLD);
+        }
+        MPI_Finalize();
+    }
+    bool isRoot() const { return rank==0; }
+    int getNofProcesses() const { return nofProcesses; }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef __GRAPH_ANALYSIS_HPP____
+#define __GRAPH_ANALYSIS_HPP____
+
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief A decomposition of the states of an MDP into strongly connected components (SCCs). The states of SCC
+ *        number i are sccStates[sccOffsets[i]] to sccStates[sccOffsets[i+1]-1]. The SCCs are sorted in reverse
+ *        topological order, i.e., no state has an edge to a state in an SCC with a higher number. An SCC is
+ *        "trivial" if it consists of a single state without a self-loop.
+ */
+struct SCCDecomposition {
+    std::vector<unsigned int> sccOffsets;
+    std::vector<unsigned int> sccStates;
+    std::vector<bool> trivial;
+    SCCDecomposition() : sccOffsets(1,0) {}
+    unsigned int nofSCCs() const { return sccOffsets.size()-1; }
+};
+
+/**
+ * @brief Computes the SCC decomposition of the graph of an MDP with Tarjan's algorithm (without recursion, so that
+ *        long chains of states do not overflow the stack). The outgoing edges of the states marked in
+ *        "statesWithoutSuccessors" are ignored. This is useful for value iteration, where states with fixed
+ *        values do not depend on their successors. The decomposition stays valid for value iteration calls in
+ *        which additional states have fixed values. The edges of all choices of a state are assumed to be
+ *        numbered consecutively.
+ * @param transitions The transition relation - can be any class offering the interface of a "TransitionMatrix"
+ * @param statesWithoutSuccessors The states whose outgoing edges are ignored - an empty vector stands for none.
+ * @return the decomposition
+ */
+template<class Transitions> SCCDecomposition computeSCCDecomposition(const Transitions &transitions, const std::vector<bool> &statesWithoutSuccessors) {
+
+    const unsigned int nofStates = transitions.nofStates();
+    const unsigned int unvisited = (unsigned int)-1;
+    std::vector<unsigned int> index(nofStates,unvisited);
+    std::vector<unsigned int> lowlink(nofStates);
+    std::vector<bool> onStack(nofStates,false);
+    std::vector<unsigned int> sccStack;
+    unsigned int nextIndex = 0;
+    SCCDecomposition result;
+    result.sccStates.reserve(nofStates);
+
+    // The call stack of the depth-first search
+    struct Frame {
+        unsigned int state;
+        unsigned int nextEdge;
+        unsigned int edgeEnd;
+    };
+    std::vector<Frame> callStack;
+    auto pushState = [&](unsigned int state) {
+        index[state] = lowlink[state] = nextIndex++;
+        sccStack.push_back(state);
+        onStack[state] = true;
+        Frame frame;
+        frame.state = state;
+        frame.nextEdge = transitions.edgeBegin(transitions.choiceBegin(state));
+        frame.edgeEnd = transitions.edgeBegin(transitions.choiceEnd(state));
+        if ((statesWithoutSuccessors.size()>0) && statesWithoutSuccessors[state]) frame.nextEdge = frame.edgeEnd;
+        callStack.push_back(frame);
+    };
+
+    for (unsigned int root=0;root<nofStates;root++) {
+        if (index[root]==unvisited) {
+            pushState(root);
+            while (callStack.size()>0) {
+                Frame &frame = callStack.back();
+                if (frame.nextEdge<frame.edgeEnd) {
+                    const unsigned int target = transitions.target(frame.state,frame.nextEdge++);
+                    if (index[target]==unvisited) {
+                        pushState(target);
+                    } else if (onStack[target]) {
+                        lowlink[frame.state] = std::min(lowlink[frame.state],index[target]);
+                    }
+                } else {
+                    const unsigned int state = frame.state;
+                    callStack.pop_back();
+                    if (callStack.size()>0) {
+                        lowlink[callStack.back().state] = std::min(lowlink[callStack.back().state],lowlink[state]);
+                    }
+                    if (lowlink[state]==index[state]) {
+                        // Found an SCC
+                        unsigned int member;
+                        do {
+                            member = sccStack.back();
+                            sccStack.pop_back();
+                            onStack[member] = false;
+                            result.sccStates.push_back(member);
+                        } while (member!=state);
+                        result.sccOffsets.push_back(result.sccStates.size());
+
+                        // Sort the states of the SCC for a more cache-friendly processing order
+                        std::sort(result.sccStates.begin()+result.sccOffsets[result.sccOffsets.size()-2],result.sccStates.end());
+
+                        // Trivial SCC?
+                        bool trivial = result.sccOffsets[result.sccOffsets.size()-2]+1==result.sccStates.size();
+                        if (trivial && !((statesWithoutSuccessors.size()>0) && statesWithoutSuccessors[state])) {
+                            for (unsigned int k=transitions.edgeBegin(transitions.choiceBegin(state));k<transitions.edgeBegin(transitions.choiceEnd(state));k++) {
+                                if (transitions.target(state,k)==state) trivial = false;
+                            }
+                        }
+                        result.trivial.push_back(trivial);
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief The predecessor relation of the graph of an MDP. The predecessors of state number i are
+ *        predecessorStates[offsets[i]] to predecessorStates[offsets[i+1]-1]. For each of them,
+ *        predecessorChoices contains the number of the choice (relative to the predecessor state)
+ *        that leads to state i. A predecessor appears once for every edge with a non-zero probability.
+ *        Adding choiceOffsets[s] to a choice number of a state s gives a number that is unique among
+ *        all choices of all states.
+ */
+struct PredecessorRelation {
+    std::vector<unsigned int> choiceOffsets;
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> predecessorStates;
+    std::vector<unsigned int> predecessorChoices;
+};
+
+/**
+ * @brief Computes the predecessor relation of the graph of an MDP. The edges of all choices of a state are assumed
+ *        to be numbered consecutively.
+ * @param transitions The transition relation - can be any class offering the interface of a "TransitionMatrix"
+ * @return the predecessor relation
+ */
+template<class Transitions> PredecessorRelation computePredecessorRelation(const Transitions &transitions) {
+
+    const unsigned int nofStates = transitions.nofStates();
+    PredecessorRelation result;
+    result.choiceOffsets.resize(nofStates+1,0);
+    result.offsets.resize(nofStates+1,0);
+    for (unsigned int state=0;state<nofStates;state++) {
+        result.choiceOffsets[state+1] = result.choiceOffsets[state]+transitions.nofChoices(state);
+        for (unsigned int k=transitions.edgeBegin(transitions.choiceBegin(state));k<transitions.edgeBegin(transitions.choiceEnd(state));k++) {
+            if (transitions.probability(k)>0.0) result.offsets[transitions.target(state,k)+1]++;
+        }
+    }
+    for (unsigned int state=0;state<nofStates;state++) result.offsets[state+1] += result.offsets[state];
+    result.predecessorStates.resize(result.offsets[nofStates]);
+    result.predecessorChoices.resize(result.offsets[nofStates]);
+    std::vector<unsigned int> fillPosition(result.offsets.begin(),result.offsets.end()-1);
+    for (unsigned int state=0;state<nofStates;state++) {
+        for (unsigned int j=0;j<transitions.nofChoices(state);j++) {
+            const unsigned int choice = transitions.choiceBegin(state)+j;
+            for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+                if (transitions.probability(k)>0.0) {
+                    unsigned int pos = fillPosition[transitions.target(state,k)]++;
+                    result.predecessorStates[pos] = state;
+                    result.predecessorChoices[pos] = j;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Computes the set of states of an MDP from which some state in "targets" can be reached with a non-zero
+ *        probability (under some policy) by a backward search. All other states have a maximal probability of 0
+ *        to reach the targets ("Prob0"). As in "computeSCCDecomposition", the outgoing edges of the states marked
+ *        in "statesWithoutSuccessors" are ignored.
+ * @param predecessors The predecessor relation of the MDP (see "computePredecessorRelation")
+ * @param targets The target states
+ * @param statesWithoutSuccessors The states whose outgoing edges are ignored
+ * @return for every state whether it can reach a target state (as 0/1 values)
+ */
+inline std::vector<char> computeStatesThatCanReach(const PredecessorRelation &predecessors, const std::vector<char> &targets, const std::vector<char> &statesWithoutSuccessors) {
+    std::vector<char> result(targets);
+    std::vector<unsigned int> todo;
+    for (unsigned int state=0;state<result.size();state++) {
+        if (result[state]) todo.push_back(state);
+    }
+    while (todo.size()>0) {
+        unsigned int state = todo.back();
+        todo.pop_back();
+        for (unsigned int j=predecessors.offsets[state];j<predecessors.offsets[state+1];j++) {
+            unsigned int predecessor = predecessors.predecessorStates[j];
+            if (!result[predecessor] && !statesWithoutSuccessors[predecessor]) {
+                result[predecessor] = 1;
+                todo.push_back(predecessor);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Computes the set of states of an MDP from which the states in "targets" can be reached with probability 1
+ *        under some policy ("Prob1E"), by the usual nested fixpoint: Starting with the states that can reach the
+ *        targets at all, the states are repeatedly restricted to those that can reach the targets with choices
+ *        that never leave the current set. For the states found, a policy that reaches the targets with
+ *        probability 1 is returned as well. It moves closer to the targets in every step, so it does not stay in
+ *        a cycle of states that all have the value 1. The transition relation itself is not needed, as the
+ *        predecessor relation covers all edges with a non-zero probability.
+ * @param predecessors The predecessor relation of the MDP (see "computePredecessorRelation")
+ * @param targets The target states
+ * @param statesWithoutSuccessors The states whose outgoing edges are ignored - must include the targets
+ * @param canReachTargets The result of "computeStatesThatCanReach" for the targets
+ * @param policy Is set to the choice to take for every state that is found (relative to the state)
+ * @return for every state whether it can reach a target state with probability 1 (as 0/1 values)
+ */
+inline std::vector<char> computeStatesThatReachWithProbabilityOne(const PredecessorRelation &predecessors, const std::vector<char> &targets, const std::vector<char> &statesWithoutSuccessors, const std::vector<char> &canReachTargets, std::vector<unsigned int> &policy) {
+
+    const unsigned int nofStates = targets.size();
+    std::vector<char> current(canReachTargets);
+    policy.resize(nofStates);
+
+    // Marks the choices that can leave "current". They are updated whenever states are removed from "current".
+    std::vector<char> choiceLeaves(predecessors.choiceOffsets[nofStates],0);
+    auto markChoicesLeading = [&](unsigned int state) {
+        for (unsigned int j=predecessors.offsets[state];j<predecessors.offsets[state+1];j++) {
+            unsigned int predecessor = predecessors.predecessorStates[j];
+            choiceLeaves[predecessors.choiceOffsets[predecessor]+predecessors.predecessorChoices[j]] = 1;
+        }
+    };
+    for (unsigned int state=0;state<nofStates;state++) {
+        if (!current[state]) markChoicesLeading(state);
+    }
+
+    while (true) {
+        // Backward search from the targets, only using choices that stay in "current"
+        std::vector<char> next(targets);
+        std::vector<unsigned int> todo;
+        for (unsigned int state=0;state<nofStates;state++) {
+            if (next[state]) todo.push_back(state);
+        }
+        while (todo.size()>0) {
+            unsigned int state = todo.back();
+            todo.pop_back();
+            for (unsigned int j=predecessors.offsets[state];j<predecessors.offsets[state+1];j++) {
+                unsigned int predecessor = predecessors.predecessorStates[j];
+                if (next[predecessor] || !current[predecessor] || statesWithoutSuccessors[predecessor]) continue;
+                if (!choiceLeaves[predecessors.choiceOffsets[predecessor]+predecessors.predecessorChoices[j]]) {
+                    next[predecessor] = 1;
+                    policy[predecessor] = predecessors.predecessorChoices[j];
+                    todo.push_back(predecessor);
+                }
+            }
+        }
+
+        // Remove the states that have not been found
+        bool changed = false;
+        for (unsigned int state=0;state<nofStates;state++) {
+            if (current[state] && !next[state]) {
+                markChoicesLeading(state);
+                changed = true;
+            }
+        }
+        if (!changed) return next;
+        current.swap(next);
+    }
+}
+
+/**
+ * @brief Checks if some of the given states form an end component of an MDP, i.e., if there is a policy under which
+ *        the MDP can stay in these states forever. States are repeatedly removed if all of their choices can leave
+ *        the remaining states (or have no edges with a non-zero probability). An end component exists if and only if
+ *        some states remain.
+ * @param predecessors The predecessor relation of the MDP (see "computePredecessorRelation")
+ * @param states The states to check (as 0/1 values)
+ * @return true if some of the states form an end component
+ */
+inline bool containsEndComponent(const PredecessorRelation &predecessors, const std::vector<char> &states) {
+
+    const unsigned int nofStates = states.size();
+    std::vector<char> current(states);
+
+    // Choices without edges and choices leading to states that are not in "current" leave "current".
+    std::vector<char> choiceLeaves(predecessors.choiceOffsets[nofStates],1);
+    for (unsigned int j=0;j<predecessors.predecessorStates.size();j++) {
+        choiceLeaves[predecessors.choiceOffsets[predecessors.predecessorStates[j]]+predecessors.predecessorChoices[j]] = 0;
+    }
+    for (unsigned int state=0;state<nofStates;state++) {
+        if (current[state]) continue;
+        for (unsigned int j=predecessors.offsets[state];j<predecessors.offsets[state+1];j++) {
+            choiceLeaves[predecessors.choiceOffsets[predecessors.predecessorStates[j]]+predecessors.predecessorChoices[j]] = 1;
+        }
+    }
+
+    // Remove the states all of whose choices leave "current", until none are left
+    std::vector<unsigned int> nofStayingChoices(nofStates,0);
+    std::vector<unsigned int> todo;
+    unsigned int nofRemainingStates = 0;
+    for (unsigned int state=0;state<nofStates;state++) {
+        if (!current[state]) continue;
+        nofRemainingStates++;
+        for (unsigned int c=predecessors.choiceOffsets[state];c<predecessors.choiceOffsets[state+1];c++) {
+            if (!choiceLeaves[c]) nofStayingChoices[state]++;
+        }
+        if (nofStayingChoices[state]==0) todo.push_back(state);
+    }
+    while (todo.size()>0) {
+        unsigned int state = todo.back();
+        todo.pop_back();
+        current[state] = 0;
+        nofRemainingStates--;
+        for (unsigned int j=predecessors.offsets[state];j<predecessors.offsets[state+1];j++) {
+            unsigned int predecessor = predecessors.predecessorStates[j];
+            unsigned int choice = predecessors.choiceOffsets[predecessor]+predecessors.predecessorChoices[j];
+            if (choiceLeaves[choice]) continue;
+            choiceLeaves[choice] = 1;
+            if (current[predecessor] && (--nofStayingChoices[predecessor]==0)) todo.push_back(predecessor);
+        }
+    }
+    return nofRemainingStates>0;
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include "mdp.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+
+//=====================================================
+// Incremental solving after changes of the MDP
+//
+// When an MDP is changed in a few states (e.g., after
+// an obstacle has been moved), the values computed for
+// its previous version are still valid for all states
+// that cannot reach a changed state. The states of the
+// two versions are related by their numbers (MDP) and
+// by their (MDP state, parity state) pairs (product).
+// A product state only counts as unchanged if it has
+// the same color and the same transitions to the
+// corresponding states. The value iteration results for
+// the previous version are then translated to the state
+// numbers of the new product, so that computeRAPolicy
+// can fix the values of the unaffected states.
+//=====================================================
+
+/**
+ * @brief Relates the states of the MDP to the ones of a previous version of it. States are identified by their
+ *        numbers, and they only correspond if they have the same label.
+ * @param previous The previous version of the MDP
+ * @return For every state: the same state in the previous version, or (unsigned int)-1 if there is none
+ */
+std::vector<unsigned int> MDP::findPreviousStates(const MDP &previous) const {
+    std::vector<unsigned int> previousStates(nofStates(),(unsigned int)-1);
+    if (labelComponents!=previous.labelComponents) return previousStates;
+    const unsigned int nofCommonStates = std::min(nofStates(),previous.nofStates());
+    #pragma omp parallel for schedule(static)
+    for (unsigned int i=0;i<nofCommonStates;i++) {
+        bool sameLabel = true;
+        for (unsigned int j=0;j<labelComponents.size();j++) {
+            if (labels.value(i,j)!=previous.labels.value(i,j)) sameLabel = false;
+        }
+        if (sameLabel) previousStates[i] = i;
+    }
+    return previousStates;
+}
+
+/**
+ * @brief Relates the states of a bisimulation quotient to the ones of the quotient of a previous version of the MDP.
+ *        Every quotient state is represented by the lowest original state in it, and two quotient states correspond
+ *        if their representatives correspond.
+ * @param mapping The mapping from the MDP to its quotient
+ * @param previousMapping The mapping from the previous version of the MDP to its quotient
+ * @param previousStates The relation between the states of the MDP and its previous version (see MDP::findPreviousStates)
+ * @return For every quotient state: the corresponding quotient state of the previous version, or (unsigned int)-1
+ */
+std::vector<unsigned int> findPreviousQuotientStates(const BisimulationQuotientMapping &mapping, const BisimulationQuotientMapping &previousMapping, const std::vector<unsigned int> &previousStates) {
+    auto findRepresentatives = [](const std::vector<unsigned int> &quotientStates) {
+        std::vector<unsigned int> representatives;
+        for (unsigned int i=0;i<quotientStates.size();i++) {
+            if (quotientStates[i]>=representatives.size()) representatives.resize(quotientStates[i]+1,(unsigned int)-1);
+            if (representatives[quotientStates[i]]==(unsigned int)-1) representatives[quotientStates[i]] = i;
+        }
+        return representatives;
+    };
+    const std::vector<unsigned int> representatives = findRepresentatives(mapping.quotientStates);
+    const std::vector<unsigned int> previousRepresentatives = findRepresentatives(previousMapping.quotientStates);
+    std::vector<unsigned int> previousQuotientStates(representatives.size(),(unsigned int)-1);
+    for (unsigned int i=0;i<representatives.size();i++) {
+        const unsigned int previousState = previousStates[representatives[i]];
+        if (previousState==(unsigned int)-1) continue;
+        const unsigned int previousQuotientState = previousMapping.quotientStates[previousState];
+        if (previousRepresentatives[previousQuotientState]==previousState) previousQuotientStates[i] = previousQuotientState;
+    }
+    return previousQuotientStates;
+}
+
+/**
+ * @brief Relates the product states to the ones of the product of the same parity automaton with a previous version
+ *        of the MDP. A product state corresponds to the previous product state with the same MDP state (as given by
+ *        "previousMDPStates") and parity state, but only if it has the same color, and if its choices have the same
+ *        actions and lead to the corresponding states with the same probabilities.
+ * @param previous The product with the previous version of the MDP
+ * @param previousMDPStates For every MDP state: the corresponding state of the previous version, or (unsigned int)-1
+ * @return For every product state: the unchanged state of the previous product, or (unsigned int)-1 if there is none
+ */
+std::vector<unsigned int> ParityMDP::findPreviousStates(const ParityMDP &previous, const std::vector<unsigned int> &previousMDPStates) const {
+
+    // Find the previous product states with the same (MDP state, parity state) pairs
+    uint64_t nofParityStates = 1;
+    for (unsigned int parityState : parityStates) nofParityStates = std::max(nofParityStates,(uint64_t)parityState+1);
+    for (unsigned int parityState : previous.parityStates) nofParityStates = std::max(nofParityStates,(uint64_t)parityState+1);
+    std::unordered_map<uint64_t,unsigned int> previousProductStates(previous.nofStates());
+    for (unsigned int i=0;i<previous.nofStates();i++) {
+        previousProductStates[(uint64_t)previous.toNonParityMDPMapper[i]*nofParityStates+previous.parityStates[i]] = i;
+    }
+    std::vector<unsigned int> counterparts(nofStates(),(unsigned int)-1);
+    #pragma omp parallel for schedule(static)
+    for (unsigned int i=0;i<nofStates();i++) {
+        const unsigned int previousMDPState = previousMDPStates[toNonParityMDPMapper[i]];
+        if (previousMDPState==(unsigned int)-1) continue;
+        auto it = previousProductStates.find((uint64_t)previousMDPState*nofParityStates+parityStates[i]);
+        if (it!=previousProductStates.end()) counterparts[i] = it->second;
+    }
+
+    // The action numbers may differ between the versions
+    std::vector<int> previousActions(actions.size(),-1);
+    for (unsigned int i=0;i<actions.size();i++) {
+        auto it = std::find(previous.actions.begin(),previous.actions.end(),actions[i]);
+        if (it!=previous.actions.end()) previousActions[i] = it-previous.actions.begin();
+    }
+
+    // Keep the counterparts of the states that have not changed
+    std::vector<unsigned int> previousStates(nofStates(),(unsigned int)-1);
+    #pragma omp parallel for schedule(dynamic,256)
+    for (unsigned int i=0;i<nofStates();i++) {
+        const unsigned int previousState = counterparts[i];
+        if (previousState==(unsigned int)-1) continue;
+        if ((colors[i]!=previous.colors[previousState]) || (transitions.nofChoices(i)!=previous.transitions.nofChoices(previousState))) continue;
+        bool unchanged = true;
+        for (unsigned int j=0;unchanged && (j<transitions.nofChoices(i));j++) {
+            const unsigned int choice = transitions.choiceBegin(i)+j;
+            const unsigned int previousChoice = previous.transitions.choiceBegin(previousState)+j;
+            const int action = transitions.choiceActions[choice];
+            if (((action==-1)?-1:previousActions[action])!=previous.transitions.choiceActions[previousChoice]) unchanged = false;
+            if ((action!=-1) && (previousActions[action]==-1)) unchanged = false;
+            const unsigned int nofEdges = transitions.edgeEnd(choice)-transitions.edgeBegin(choice);
+            if (nofEdges!=previous.transitions.edgeEnd(previousChoice)-previous.transitions.edgeBegin(previousChoice)) unchanged = false;
+            for (unsigned int k=0;unchanged && (k<nofEdges);k++) {
+                const unsigned int edge = transitions.edgeBegin(choice)+k;
+                const unsigned int previousEdge = previous.transitions.edgeBegin(previousChoice)+k;
+                if ((transitions.probabilities[edge]!=previous.transitions.probabilities[previousEdge])
+                    || (counterparts[transitions.targets[edge]]!=previous.transitions.targets[previousEdge])) unchanged = false;
+            }
+        }
+        if (unchanged) previousStates[i] = previousState;
+    }
+    return previousStates;
+}
+
+/**
+ * @brief Takes over the value iteration results for the previous version of the parity MDP, translated to the state
+ *        numbers of the current version. If no results have been computed for the previous version, the results it
+ *        has taken over from its own previous version are used instead. Results with upper bounds (from interval
+ *        iteration) are not taken over, as they may stem from value iteration calls that have stopped early.
+ * @param previous The cache for the previous version of the parity MDP
+ * @param previousStates For every state of the current version: the unchanged state of the previous version, or
+ *        (unsigned int)-1 (see ParityMDP::findPreviousStates)
+ */
+void ValueIterationCache::setPreviousVersion(const ValueIterationCache &previous, const std::vector<unsigned int> &previousStates) {
+    const unsigned int nofStates = previousStates.size();
+    const bool chained = previous.entries.empty() && previous.hasPreviousVersion();
+
+    changedStates.assign(nofStates,0);
+    std::vector<unsigned int> currentStates;
+    for (unsigned int i=0;i<nofStates;i++) {
+        const unsigned int previousState = previousStates[i];
+        if ((previousState==(unsigned int)-1) || (chained && previous.changedStates[previousState])) {
+            changedStates[i] = 1;
+        } else {
+            if (previousState>=currentStates.size()) currentStates.resize(previousState+1,(unsigned int)-1);
+            currentStates[previousState] = i;
+        }
+    }
+    auto translateStates = [&currentStates](const std::vector<unsigned int> &states) {
+        std::vector<unsigned int> result;
+        for (unsigned int state : states) {
+            if ((state<currentStates.size()) && (currentStates[state]!=(unsigned int)-1)) result.push_back(currentStates[state]);
+        }
+        std::sort(result.begin(),result.end());
+        return result;
+    };
+
+    previousVersionEntries.clear();
+    auto translateEntry = [&](const Entry &entry) {
+        if (!entry.upperBounds.empty()) return;
+        // The final value iteration runs on the parity MDP, all others also on the backup copies of the states
+        const bool backupCopies = entry.key.minGoalColor!=(unsigned int)-1;
+        const unsigned int nofPreviousStates = backupCopies?(entry.values.size()/2):entry.values.size();
+        Entry translated;
+        translated.key = entry.key;
+        translated.key.goalStates = translateStates(entry.key.goalStates);
+        translated.key.winningStates = translateStates(entry.key.winningStates);
+        translated.values.resize(backupCopies?(2*nofStates):nofStates,std::pair<double,unsigned int>(0.0,0));
+        for (unsigned int i=0;i<nofStates;i++) {
+            if (changedStates[i] || (previousStates[i]>=nofPreviousStates)) continue;
+            translated.values[i] = entry.values[previousStates[i]];
+            if (backupCopies) translated.values[i+nofStates] = entry.values[previousStates[i]+nofPreviousStates];
+        }
+        previousVersionEntries.push_back(std::move(translated));
+    };
+    if (chained) {
+        for (const Entry &entry : previous.previousVersionEntries) translateEntry(entry);
+    } else {
+        for (const Entry &entry : previous.entries) translateEntry(entry);
+    }
+}
+
+/**
+ * @brief Finds the result for the previous version of the parity MDP that is the most similar to a value iteration
+ *        problem: It must have been computed with the same settings and goal color, and its goal states and winning
+ *        states differ from the ones of the problem in as few states as possible.
+ * @param key The value iteration problem
+ * @param values Is set to the result for the previous version if one is found
+ * @param differingStates Is set to the states (of the value iteration problem) that have changed since the previous
+ *        version, or whose values are fixed differently in the problem and in the result found
+ * @return true if a result has been found
+ */
+bool ValueIterationCache::lookupPreviousVersion(const Key &key, std::vector<std::pair<double,unsigned int> > &values, std::vector<char> &differingStates) const {
+    const Entry *bestEntry = NULL;
+    std::vector<unsigned int> bestDifferences;
+    for (const Entry &entry : previousVersionEntries) {
+        if ((entry.key.minGoalColor!=key.minGoalColor) || (entry.key.epsilon!=key.epsilon) || (entry.key.computePolicyEagerly!=key.computePolicyEagerly)
+            || (entry.key.method!=key.method) || (entry.key.intervalIteration!=key.intervalIteration) || (entry.key.singlePrecision!=key.singlePrecision)
+            || (entry.key.warmStart!=key.warmStart)) continue;
+        std::vector<unsigned int> differences;
+        std::set_symmetric_difference(entry.key.goalStates.begin(),entry.key.goalStates.end(),key.goalStates.begin(),key.goalStates.end(),std::back_inserter(differences));
+        std::set_symmetric_difference(entry.key.winningStates.begin(),entry.key.winningStates.end(),key.winningStates.begin(),key.winningStates.end(),std::back_inserter(differences));
+        if ((bestEntry==NULL) || (differences.size()<bestDifferences.size())) {
+            bestEntry = &entry;
+            bestDifferences.swap(differences);
+        }
+    }
+    if (bestEntry==NULL) return false;
+
+    values = bestEntry->values;
+    const unsigned int nofStates = changedStates.size();
+    const bool backupCopies = values.size()>nofStates;
+    differingStates.assign(values.size(),0);
+    auto markState = [&](unsigned int state) {
+        differingStates[state] = 1;
+        if (backupCopies) differingStates[state+nofStates] = 1;
+    };
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (changedStates[i]) markState(i);
+    }
+    for (unsigned int state : bestDifferences) markState(state);
+    return true;
+}
+
+//=====================================================
+// Fingerprints
+//
+// Value iteration result files are only valid for the
+// product they have been computed for. The files thus
+// store 64-bit hashes (FNV-1a over 64-bit words) of the
+// parity automaton and of the product, and results are
+// only taken over if they match the ones for the
+// previous version of the MDP.
+//=====================================================
+
+namespace {
+
+inline void addToFingerprint(uint64_t &fingerprint, uint64_t part) {
+    fingerprint = (fingerprint ^ part)*1099511628211ull;
+}
+
+template<class T> void addArrayToFingerprint(uint64_t &fingerprint, const std::vector<T> &array) {
+    addToFingerprint(fingerprint,array.size());
+    for (const T &element : array) addToFingerprint(fingerprint,(uint64_t)element);
+}
+
+}
+
+/**
+ * @brief Computes a hash of the colors and transitions of the parity automaton
+ * @return the hash
+ */
+uint64_t ParityAutomaton::fingerprint() const {
+    uint64_t result = 14695981039346656037ull;
+    addArrayToFingerprint(result,colors);
+    addToFingerprint(result,transitions.size());
+    for (const auto &transition : transitions) {
+        addToFingerprint(result,transition.first.first);
+        addToFingerprint(result,transition.first.second.size());
+        for (char c : transition.first.second) addToFingerprint(result,(unsigned char)c);
+        addToFingerprint(result,transition.second);
+    }
+    return result;
+}
+
+/**
+ * @brief Computes a hash of the transitions and colors of the parity MDP, and of the MDP and parity automaton
+ *        states that its states belong to
+ * @return the hash
+ */
+uint64_t ParityMDP::fingerprint() const {
+    uint64_t result = 14695981039346656037ull;
+    addArrayToFingerprint(result,transitions.stateOffsets);
+    addArrayToFingerprint(result,transitions.choiceOffsets);
+    addArrayToFingerprint(result,transitions.choiceActions);
+    addToFingerprint(result,transitions.probabilities.size());
+    for (double probability : transitions.probabilities) {
+        uint64_t bits;
+        memcpy(&bits,&probability,sizeof(bits));
+        addToFingerprint(result,bits);
+    }
+    addArrayToFingerprint(result,transitions.targets);
+    addArrayToFingerprint(result,colors);
+    addArrayToFingerprint(result,toNonParityMDPMapper);
+    addArrayToFingerprint(result,parityStates);
+    return result;
+}
@@ -0,0 +1,32 @@
+# QMake Build file for libramps, the library version of RAMPS with a C interface
+# (see "ramps.h"). It uses the same sources as "../Tool.pro", except for the main
+# function of RAMPS.
+QMAKE_CC = gcc
+QMAKE_LINK_C = gcc
+QMAKE_CXX = g++
+QMAKE_LINK = g++
+DEFINES += # No NDEBUG here.
+CFLAGS += -g -fpermissive
+
+QMAKE_CFLAGS_RELEASE += -g -march=native -fopenmp
+QMAKE_CXXFLAGS_RELEASE += -g -std=c++11  -march=native -fopenmp
+QMAKE_CFLAGS_DEBUG += -g -Wall -Wextra  -march=native -fopenmp
+QMAKE_CXXFLAGS_DEBUG += -g -std=c++11 -Wall -Wextra  -march=native -fopenmp
+QMAKE_LFLAGS += -fopenmp
+
+TEMPLATE = lib
+CONFIG += release
+CONFIG -= app_bundle
+CONFIG -= qt
+
+HEADERS += ramps.h ../mdp.hpp ../valueIteration.hpp ../memoryMappedFile.hpp ../graphAnalysis.hpp ../singlePrecisionValueIteration.hpp ../statistics.hpp ../distributedValueIteration.hpp
+
+SOURCES += rampsLibrary.cpp ../mdp.cpp ../computePolicy.cpp ../memoryMappedFile.cpp ../binaryMDPFile.cpp ../singlePrecisionValueIteration.cpp ../bisimulation.cpp ../strategy.cpp ../statistics.cpp ../mdpBuilder.cpp ../policySearch.cpp ../incrementalSolving.cpp
+
+TARGET = ramps
+INCLUDEPATH =
+
+LIBS +=
+
+PKGCONFIG += 
+QT -= gui core
@@ -0,0 +1,67 @@
+#ifndef __RAMPS_H____
+#define __RAMPS_H____
+
+/**
+ * C interface of libramps. It allows programs to hand over MDPs and parity automata in memory and to obtain the
+ * computed RA policies as arrays, without writing any files. All functions that return an int return 0 on success
+ * and -1 on failure, and all functions that return a pointer return NULL on failure. The reason of the last failure
+ * in the calling thread can be obtained with "rampsLastError".
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RampsMDPBuilder RampsMDPBuilder;
+typedef struct RampsMDP RampsMDP;
+typedef struct RampsPolicy RampsPolicy;
+
+/**
+ * @brief Parameters of the policy computation. "rampsInitSettings" sets them to the defaults of the "ramps" tool.
+ */
+typedef struct RampsSettings {
+    const char *searchStrategy; /* As with "--ses" */
+    double minQuality; /* As with "--min" */
+    double maxQuality; /* As with "--max" */
+    int valueIterationMethod; /* 0: unsynchronized, 1: gaussSeidel, 2: topological */
+    int intervalIteration;
+    int singlePrecision;
+    int qualitativePrecomputation;
+    int strategyStoringValueIteration;
+    int bisimulation;
+    unsigned int valueIterationCacheSize; /* in MB */
+    unsigned int nofParallelProbes;
+    int warmStart;
+} RampsSettings;
+
+const char *rampsLastError(void);
+void rampsInitSettings(RampsSettings *settings);
+
+/* Building MDPs */
+RampsMDPBuilder *rampsCreateMDPBuilder(unsigned int nofLabelComponents, const char *const *labelComponents);
+int rampsAddState(RampsMDPBuilder *builder, const char *const *label);
+int rampsAddChoice(RampsMDPBuilder *builder, const char *action);
+int rampsAddEdges(RampsMDPBuilder *builder, unsigned int nofEdges, const unsigned int *targets, const double *probabilities);
+int rampsSetInitialState(RampsMDPBuilder *builder, unsigned int state);
+RampsMDP *rampsBuildMDP(RampsMDPBuilder *builder);
+void rampsFreeMDPBuilder(RampsMDPBuilder *builder);
+
+/* MDPs */
+RampsMDP *rampsReadMDP(const char *baseFilename, int binary);
+unsigned int rampsNofStates(const RampsMDP *mdp);
+void rampsFreeMDP(RampsMDP *mdp);
+
+/* Policies. The parity automaton is given in the format of the ".parity" files. */
+RampsPolicy *rampsComputePolicy(const RampsMDP *mdp, const char *parityAutomaton, const RampsSettings *settings);
+double rampsPolicyQuality(const RampsPolicy *policy);
+unsigned int rampsPolicyNofEntries(const RampsPolicy *policy);
+unsigned int rampsPolicyNofUpdates(const RampsPolicy *policy);
+void rampsGetPolicyEntries(const RampsPolicy *policy, unsigned int *states, unsigned int *dataStates, unsigned int *mdpStates, unsigned int *actions);
+void rampsGetPolicyUpdates(const RampsPolicy *policy, unsigned int *updateOffsets, unsigned int *mdpStates, unsigned int *states, unsigned int *dataStates);
+void rampsFreePolicy(RampsPolicy *policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+#
+# Python binding for libramps (see "ramps.h"), based on ctypes.
+#
+# Example:
+#
+#   import ramps
+#   builder = ramps.MDPBuilder(["region"])
+#   builder.addState(["0"])
+#   builder.addChoice("stay",[(0,1.0)])
+#   builder.addChoice("go",[(1,0.9),(0,0.1)])
+#   builder.addState(["1"])
+#   builder.addChoice("stay",[(1,1.0)])
+#   mdp = builder.build()
+#   policy = ramps.computePolicy(mdp,"1 2\n0 region=1 1\n1 region=0 0\n")
+#   print(policy.quality, policy.asDict())
+#
+# The library is searched for in the file given by the environment variable
+# RAMPS_LIBRARY, and otherwise as "libramps.so" next to this file and in the
+# default search path of the system.
+
+import ctypes
+import os
+
+# ==================================
+# Loading the library
+# ==================================
+class RampsError(Exception):
+    pass
+
+class _Settings(ctypes.Structure):
+    _fields_ = [("searchStrategy",ctypes.c_char_p),
+                ("minQuality",ctypes.c_double),
+                ("maxQuality",ctypes.c_double),
+                ("valueIterationMethod",ctypes.c_int),
+                ("intervalIteration",ctypes.c_int),
+                ("singlePrecision",ctypes.c_int),
+                ("qualitativePrecomputation",ctypes.c_int),
+                ("strategyStoringValueIteration",ctypes.c_int),
+                ("bisimulation",ctypes.c_int),
+                ("valueIterationCacheSize",ctypes.c_uint),
+                ("nofParallelProbes",ctypes.c_uint),
+                ("warmStart",ctypes.c_int)]
+
+def _loadLibrary():
+    candidates = []
+    if "RAMPS_LIBRARY" in os.environ:
+        candidates.append(os.environ["RAMPS_LIBRARY"])
+    candidates.append(os.path.join(os.path.dirname(os.path.abspath(__file__)),"libramps.so"))
+    candidates.append("libramps.so")
+    for candidate in candidates:
+        try:
+            return ctypes.CDLL(candidate)
+        except OSError:
+            pass
+    raise RampsError("Cannot load libramps. Tried: "+", ".join(candidates))
+
+_lib = _loadLibrary()
+_uintPointer = ctypes.POINTER(ctypes.c_uint)
+_doublePointer = ctypes.POINTER(ctypes.c_double)
+_stringArray = ctypes.POINTER(ctypes.c_char_p)
+for (name,resultType,argumentTypes) in [
+        ("rampsLastError",ctypes.c_char_p,[]),
+        ("rampsInitSettings",None,[ctypes.POINTER(_Settings)]),
+        ("rampsCreateMDPBuilder",ctypes.c_void_p,[ctypes.c_uint,_stringArray]),
+        ("rampsAddState",ctypes.c_int,[ctypes.c_void_p,_stringArray]),
+        ("rampsAddChoice",ctypes.c_int,[ctypes.c_void_p,ctypes.c_char_p]),
+        ("rampsAddEdges",ctypes.c_int,[ctypes.c_void_p,ctypes.c_uint,_uintPointer,_doublePointer]),
+        ("rampsSetInitialState",ctypes.c_int,[ctypes.c_void_p,ctypes.c_uint]),
+        ("rampsBuildMDP",ctypes.c_void_p,[ctypes.c_void_p]),
+        ("rampsFreeMDPBuilder",None,[ctypes.c_void_p]),
+        ("rampsReadMDP",ctypes.c_void_p,[ctypes.c_char_p,ctypes.c_int]),
+        ("rampsNofStates",ctypes.c_uint,[ctypes.c_void_p]),
+        ("rampsFreeMDP",None,[ctypes.c_void_p]),
+        ("rampsComputePolicy",ctypes.c_void_p,[ctypes.c_void_p,ctypes.c_char_p,ctypes.POINTER(_Settings)]),
+        ("rampsPolicyQuality",ctypes.c_double,[ctypes.c_void_p]),
+        ("rampsPolicyNofEntries",ctypes.c_uint,[ctypes.c_void_p]),
+        ("rampsPolicyNofUpdates",ctypes.c_uint,[ctypes.c_void_p]),
+        ("rampsGetPolicyEntries",None,[ctypes.c_void_p,_uintPointer,_uintPointer,_uintPointer,_uintPointer]),
+        ("rampsGetPolicyUpdates",None,[ctypes.c_void_p,_uintPointer,_uintPointer,_uintPointer,_uintPointer]),
+        ("rampsFreePolicy",None,[ctypes.c_void_p])]:
+    function = getattr(_lib,name)
+    function.restype = resultType
+    function.argtypes = argumentTypes
+
+def _bytes(text):
+    if isinstance(text,bytes):
+        return text
+    return str(text).encode("utf-8")
+
+def _strings(texts):
+    texts = [_bytes(a) for a in texts]
+    return (ctypes.c_char_p*max(1,len(texts)))(*texts)
+
+def _check(result):
+    if result is None or result==-1:
+        raise RampsError(_lib.rampsLastError().decode("utf-8","replace"))
+    return result
+
+# ==================================
+# MDPs
+# ==================================
+class MDP(object):
+    """An MDP held by libramps. It is built with an MDPBuilder or read from files with "MDP.read"."""
+    def __init__(self,handle):
+        self._handle = handle
+
+    @staticmethod
+    def read(baseFilename,binary=False):
+        return MDP(_check(_lib.rampsReadMDP(_bytes(baseFilename),1 if binary else 0)))
+
+    def nofStates(self):
+        return _lib.rampsNofStates(self._handle)
+
+    def __del__(self):
+        if self._handle is not None:
+            _lib.rampsFreeMDP(self._handle)
+            self._handle = None
+
+class MDPBuilder(object):
+    """Builds an MDP state by state, in the order of the state numbers. Every state label consists of one value
+    per label component. "addChoice" adds a transition with an action (or None) and a list of (target state,
+    probability) pairs to the last state added. Targets may be states that are only added later."""
+    def __init__(self,labelComponents):
+        self._nofLabelComponents = len(labelComponents)
+        self._handle = _check(_lib.rampsCreateMDPBuilder(len(labelComponents),_strings(labelComponents)))
+
+    def addState(self,label):
+        if len(label)!=self._nofLabelComponents:
+            raise RampsError("A state label needs "+str(self._nofLabelComponents)+" components.")
+        _check(_lib.rampsAddState(self._handle,_strings(label)))
+
+    def addChoice(self,action,edges):
+        _check(_lib.rampsAddChoice(self._handle,None if action is None else _bytes(action)))
+        targets = (ctypes.c_uint*len(edges))(*[a for (a,b) in edges])
+        probabilities = (ctypes.c_double*len(edges))(*[b for (a,b) in edges])
+        _check(_lib.rampsAddEdges(self._handle,len(edges),targets,probabilities))
+
+    def setInitialState(self,state):
+        _check(_lib.rampsSetInitialState(self._handle,state))
+
+    def build(self):
+        """Checks the MDP and returns it. The builder cannot be used afterwards."""
+        mdp = MDP(_check(_lib.rampsBuildMDP(self._handle)))
+        self._free()
+        return mdp
+
+    def _free(self):
+        if self._handle is not None:
+            _lib.rampsFreeMDPBuilder(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self._free()
+
+# ==================================
+# Policies
+# ==================================
+class Policy(object):
+    """An RA policy with the same contents as the strategy files written by RAMPS: For every entry i, the policy
+    state "states[i]" and data state "dataStates[i]", the MDP state "mdpStates[i]" in which it is used, and the
+    chosen transition "actions[i]". The memory updates of entry i are the updates updateOffsets[i] to
+    updateOffsets[i+1]-1, each with the successor MDP state, policy state, and data state."""
+    def __init__(self,handle):
+        try:
+            self.quality = _lib.rampsPolicyQuality(handle)
+            nofEntries = _lib.rampsPolicyNofEntries(handle)
+            nofUpdates = _lib.rampsPolicyNofUpdates(handle)
+            self.states = (ctypes.c_uint*nofEntries)()
+            self.dataStates = (ctypes.c_uint*nofEntries)()
+            self.mdpStates = (ctypes.c_uint*nofEntries)()
+            self.actions = (ctypes.c_uint*nofEntries)()
+            _lib.rampsGetPolicyEntries(handle,self.states,self.dataStates,self.mdpStates,self.actions)
+            self.updateOffsets = (ctypes.c_uint*(nofEntries+1))()
+            self.updateMDPStates = (ctypes.c_uint*nofUpdates)()
+            self.updateStates = (ctypes.c_uint*nofUpdates)()
+            self.updateDataStates = (ctypes.c_uint*nofUpdates)()
+            _lib.rampsGetPolicyUpdates(handle,self.updateOffsets,self.updateMDPStates,self.updateStates,self.updateDataStates)
+        finally:
+            _lib.rampsFreePolicy(handle)
+
+    def nofEntries(self):
+        return len(self.states)
+
+    def asDict(self):
+        """Returns the policy in the form used by the simulators: a map from (state, data state) pairs to lists
+        [MDP state, action, {successor MDP state: (state, data state)}]"""
+        policy = {}
+        for i in range(len(self.states)):
+            updates = {}
+            for k in range(self.updateOffsets[i],self.updateOffsets[i+1]):
+                updates[self.updateMDPStates[k]] = (self.updateStates[k],self.updateDataStates[k])
+            policy[(self.states[i],self.dataStates[i])] = [self.mdpStates[i],self.actions[i],updates]
+        return policy
+
+_valueIterationMethods = {"unsynchronized":0, "gaussSeidel":1, "topological":2}
+
+def computePolicy(mdp,parityAutomaton,searchStrategy="b:0.01:0.05",minQuality=0.0,maxQuality=1.0,valueIterationMethod="unsynchronized",
+                  intervalIteration=False,singlePrecision=False,qualitativePrecomputation=True,strategyStoringValueIteration=False,
+                  bisimulation=False,valueIterationCacheSize=1024,nofParallelProbes=4,warmStart=False):
+    """Computes the best RA policy for an MDP and a parity automaton, given in the format of the ".parity" files.
+    The parameters correspond to the command line parameters of RAMPS."""
+    if valueIterationMethod not in _valueIterationMethods:
+        raise RampsError("Unknown value iteration method '"+valueIterationMethod+"'.")
+    settings = _Settings()
+    _lib.rampsInitSettings(ctypes.byref(settings))
+    searchStrategyBytes = _bytes(searchStrategy)
+    settings.searchStrategy = searchStrategyBytes
+    settings.minQuality = minQuality
+    settings.maxQuality = maxQuality
+    settings.valueIterationMethod = _valueIterationMethods[valueIterationMethod]
+    settings.intervalIteration = 1 if intervalIteration else 0
+    settings.singlePrecision = 1 if singlePrecision else 0
+    settings.qualitativePrecomputation = 1 if qualitativePrecomputation else 0
+    settings.strategyStoringValueIteration = 1 if strategyStoringValueIteration else 0
+    settings.bisimulation = 1 if bisimulation else 0
+    settings.valueIterationCacheSize = valueIterationCacheSize
+    settings.nofParallelProbes = nofParallelProbes
+    settings.warmStart = 1 if warmStart else 0
+    return Policy(_check(_lib.rampsComputePolicy(mdp._handle,_bytes(parityAutomaton),ctypes.byref(settings))))
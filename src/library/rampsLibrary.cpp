@@ -0,0 +1,241 @@
+#include "ramps.h"
+#include "../mdp.hpp"
+#include <sstream>
+#include <memory>
+#include <new>
+#include <exception>
+
+//=====================================================
+// C interface of libramps
+//
+// The opaque handles wrap the C++ classes. Exceptions
+// must not cross the C interface, so every function
+// catches them and stores the error message for
+// "rampsLastError".
+//=====================================================
+
+struct RampsMDPBuilder {
+    MDPBuilder builder;
+    RampsMDPBuilder(const std::vector<std::string> &labelComponents) : builder(labelComponents) {}
+};
+
+struct RampsMDP {
+    MDP mdp;
+    RampsMDP(MDP &&_mdp) : mdp(std::move(_mdp)) {}
+};
+
+struct RampsPolicy {
+    Strategy strategy;
+    std::vector<unsigned int> mdpStates; // The MDP state of every state of the strategy
+    double quality;
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+/**
+ * @brief Runs a function and turns the exceptions thrown by RAMPS into an error message
+ * @return Whether the function has been run without an exception
+ */
+template<class Function> bool runGuarded(const Function &function) {
+    try {
+        function();
+        return true;
+    } catch (int error) {
+        std::ostringstream message;
+        message << "Numerical error " << error;
+        lastError = message.str();
+    } catch (const char *error) {
+        lastError = error;
+    } catch (const std::string &error) {
+        lastError = error;
+    } catch (const std::bad_alloc &) {
+        lastError = "Out of memory.";
+    } catch (const std::exception &error) {
+        lastError = error.what();
+    } catch (...) {
+        lastError = "Unknown error.";
+    }
+    return false;
+}
+
+}
+
+const char *rampsLastError(void) {
+    return lastError.c_str();
+}
+
+void rampsInitSettings(RampsSettings *settings) {
+    const ValueIterationSettings defaults;
+    settings->searchStrategy = "b:0.01:0.05";
+    settings->minQuality = 0.0;
+    settings->maxQuality = 1.0;
+    settings->valueIterationMethod = defaults.method;
+    settings->intervalIteration = defaults.intervalIteration;
+    settings->singlePrecision = defaults.singlePrecision;
+    settings->qualitativePrecomputation = defaults.qualitativePrecomputation;
+    settings->strategyStoringValueIteration = defaults.computePolicyEagerly;
+    settings->bisimulation = 0;
+    settings->valueIterationCacheSize = 1024;
+    settings->nofParallelProbes = 4;
+    settings->warmStart = defaults.warmStart;
+}
+
+RampsMDPBuilder *rampsCreateMDPBuilder(unsigned int nofLabelComponents, const char *const *labelComponents) {
+    RampsMDPBuilder *result = NULL;
+    runGuarded([&]() {
+        result = new RampsMDPBuilder(std::vector<std::string>(labelComponents,labelComponents+nofLabelComponents));
+    });
+    return result;
+}
+
+int rampsAddState(RampsMDPBuilder *builder, const char *const *label) {
+    return runGuarded([&]() {
+        builder->builder.addState(std::vector<std::string>(label,label+builder->builder.nofLabelComponents()));
+    })?0:-1;
+}
+
+int rampsAddChoice(RampsMDPBuilder *builder, const char *action) {
+    return runGuarded([&]() {
+        builder->builder.addChoice((action==NULL)?"":action);
+    })?0:-1;
+}
+
+int rampsAddEdges(RampsMDPBuilder *builder, unsigned int nofEdges, const unsigned int *targets, const double *probabilities) {
+    return runGuarded([&]() {
+        for (unsigned int i=0;i<nofEdges;i++) builder->builder.addEdge(targets[i],probabilities[i]);
+    })?0:-1;
+}
+
+int rampsSetInitialState(RampsMDPBuilder *builder, unsigned int state) {
+    builder->builder.setInitialState(state);
+    return 0;
+}
+
+RampsMDP *rampsBuildMDP(RampsMDPBuilder *builder) {
+    RampsMDP *result = NULL;
+    runGuarded([&]() {
+        result = new RampsMDP(builder->builder.build());
+    });
+    return result;
+}
+
+void rampsFreeMDPBuilder(RampsMDPBuilder *builder) {
+    delete builder;
+}
+
+RampsMDP *rampsReadMDP(const char *baseFilename, int binary) {
+    RampsMDP *result = NULL;
+    runGuarded([&]() {
+        result = new RampsMDP(MDP(baseFilename,binary?MDP::BINARY_FILE:MDP::PRISM_FILES));
+    });
+    return result;
+}
+
+unsigned int rampsNofStates(const RampsMDP *mdp) {
+    return mdp->mdp.nofStates();
+}
+
+void rampsFreeMDP(RampsMDP *mdp) {
+    delete mdp;
+}
+
+/**
+ * @brief Computes the best RA policy in the same way as the "ramps" tool. The states of the policy are the states of
+ *        the product of the MDP and the parity automaton, or, with bisimulation minimization, pairs of MDP states and
+ *        product states, as in the output of the "ramps" tool.
+ */
+RampsPolicy *rampsComputePolicy(const RampsMDP *mdp, const char *parityAutomaton, const RampsSettings *settings) {
+    RampsPolicy *result = NULL;
+    runGuarded([&]() {
+        ParityAutomaton automaton;
+        std::istringstream automatonText(parityAutomaton);
+        automaton.read(automatonText);
+
+        PolicySearchSettings searchSettings;
+        searchSettings.searchStrategy = parseSearchStrategy(settings->searchStrategy);
+        searchSettings.minQuality = settings->minQuality;
+        searchSettings.maxQuality = settings->maxQuality;
+        searchSettings.nofParallelProbes = settings->nofParallelProbes;
+        ValueIterationSettings &valueIterationSettings = searchSettings.valueIterationSettings;
+        switch (settings->valueIterationMethod) {
+        case 0:
+            valueIterationSettings.method = ValueIterationSettings::UNSYNCHRONIZED;
+            break;
+        case 1:
+            valueIterationSettings.method = ValueIterationSettings::BLOCK_GAUSS_SEIDEL;
+            break;
+        case 2:
+            valueIterationSettings.method = ValueIterationSettings::TOPOLOGICAL;
+            break;
+        default:
+            throw "Error: Unknown value iteration method.";
+        }
+        valueIterationSettings.intervalIteration = settings->intervalIteration;
+        valueIterationSettings.singlePrecision = settings->singlePrecision;
+        valueIterationSettings.qualitativePrecomputation = settings->qualitativePrecomputation;
+        valueIterationSettings.computePolicyEagerly = settings->strategyStoringValueIteration;
+        valueIterationSettings.warmStart = settings->warmStart;
+
+        std::unique_ptr<MDP> quotientMDP;
+        BisimulationQuotientMapping quotientMapping;
+        if (settings->bisimulation) {
+            std::vector<bool> relevantComponents;
+            std::vector<bool> relevantActions;
+            ParityMDP::findReferencedLabels(automaton,mdp->mdp,relevantComponents,relevantActions);
+            quotientMDP.reset(new MDP(mdp->mdp,relevantComponents,relevantActions,quotientMapping));
+        }
+        const ParityMDP parityMDP(automaton,settings->bisimulation?*quotientMDP:mdp->mdp);
+
+        ValueIterationCache valueIterationCache(settings->valueIterationCacheSize);
+        std::pair<Strategy,double> bestStrategy = parityMDP.searchRAPolicy(searchSettings,(settings->valueIterationCacheSize>0)?&valueIterationCache:NULL);
+
+        std::unique_ptr<RampsPolicy> policy(new RampsPolicy());
+        policy->quality = bestStrategy.second;
+        if (settings->bisimulation) {
+            policy->strategy = parityMDP.mapPolicyToOriginalMDP(bestStrategy.first,mdp->mdp,quotientMapping,policy->mdpStates);
+        } else {
+            policy->strategy = std::move(bestStrategy.first);
+            policy->mdpStates = parityMDP.mdpStates();
+        }
+        result = policy.release();
+    });
+    return result;
+}
+
+double rampsPolicyQuality(const RampsPolicy *policy) {
+    return policy->quality;
+}
+
+unsigned int rampsPolicyNofEntries(const RampsPolicy *policy) {
+    return policy->strategy.nofEntries();
+}
+
+unsigned int rampsPolicyNofUpdates(const RampsPolicy *policy) {
+    return policy->strategy.updateBegin(policy->strategy.nofEntries());
+}
+
+void rampsGetPolicyEntries(const RampsPolicy *policy, unsigned int *states, unsigned int *dataStates, unsigned int *mdpStates, unsigned int *actions) {
+    const Strategy &strategy = policy->strategy;
+    for (unsigned int i=0;i<strategy.nofEntries();i++) {
+        states[i] = strategy.state(i);
+        dataStates[i] = strategy.dataState(i);
+        mdpStates[i] = policy->mdpStates[strategy.state(i)];
+        actions[i] = strategy.action(i);
+    }
+}
+
+void rampsGetPolicyUpdates(const RampsPolicy *policy, unsigned int *updateOffsets, unsigned int *mdpStates, unsigned int *states, unsigned int *dataStates) {
+    const Strategy &strategy = policy->strategy;
+    for (unsigned int i=0;i<=strategy.nofEntries();i++) updateOffsets[i] = strategy.updateBegin(i);
+    for (unsigned int k=0;k<strategy.updateBegin(strategy.nofEntries());k++) {
+        mdpStates[k] = policy->mdpStates[strategy.updateState(k)];
+        states[k] = strategy.updateState(k);
+        dataStates[k] = strategy.updateDataState(k);
+    }
+}
+
+void rampsFreePolicy(RampsPolicy *policy) {
+    delete policy;
+}
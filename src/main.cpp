@@ -1,21 +1,55 @@
 #include <iostream>
 #include <sstream>
-#include <tuple>
 #include <sstream>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <exception>
 #include "mdp.hpp"
+#include "singlePrecisionValueIteration.hpp"
+#include "server.hpp"
+#include "batch.hpp"
+#include "distributedValueIteration.hpp"
 
 
 
 int main(int nofArgs, const char **args) {
 
+#ifdef USE_MPI
+    // Only the first MPI process reads the MDP and searches for the policy. The other processes only work on their
+    // slices of the problems of the distributed value iteration method.
+    MPIEnvironment mpiEnvironment(&nofArgs,const_cast<char***>(&args));
+    if (!mpiEnvironment.isRoot()) {
+        runDistributedValueIterationWorker();
+        return 0;
+    }
+#endif
+
     try {
 
         // Parse parameters
         std::string baseFilename = "";
+        std::vector<std::string> baseFilenames;
         std::string searchStrategy = "";
         double minQuality = 0.0;
         double maxQuality = 1.0;
-        bool computePolicyEagerly = false;
+        ValueIterationSettings valueIterationSettings;
+        bool convertToBinaryMDP = false;
+        bool bisimulation = false;
+        std::string binaryStrategyFilename = "";
+        std::string statisticsFilename = "";
+        unsigned int valueIterationCacheSize = 1024; // in MB
+        unsigned int nofParallelProbes = 4; // for the 'k'-ary search
+        MDP::InputFormat inputFormat = MDP::PRISM_FILES;
+        bool serverMode = false;
+        std::string socketPath = "";
+        unsigned int maxNofCachedProducts = 8; // in server mode
+        std::vector<std::string> parityPaths; // parity automaton files and directories for the batch mode
+        unsigned int nofParallelSpecifications = 4; // in batch mode
+        std::string outputDirectory = ""; // in batch mode
+        std::string saveSolutionFilename = "";
+        std::string previousModelName = "";
+        std::string previousSolutionFilename = "";
 
         for (int i=1;i<nofArgs;i++) {
             if (args[i][0]=='-') {
@@ -55,7 +89,139 @@ int main(int nofArgs, const char **args) {
                         return 1;
                     }
                 } else if (param=="--strategyStoringValueIteration") {
-                    computePolicyEagerly = true;
+                    valueIterationSettings.computePolicyEagerly = true;
+                } else if (param=="--intervalIteration") {
+                    valueIterationSettings.intervalIteration = true;
+                } else if (param=="--warmStart") {
+                    valueIterationSettings.warmStart = true;
+                } else if (param=="--noQualitativePrecomputation") {
+                    valueIterationSettings.qualitativePrecomputation = false;
+                } else if (param=="--singlePrecision") {
+                    valueIterationSettings.singlePrecision = true;
+                } else if (param=="--valueIterationMethod") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No parameter after '--valueIterationMethod'.\n";
+                        return 1;
+                    }
+                    std::string method = args[++i];
+                    if (method=="unsynchronized") {
+                        valueIterationSettings.method = ValueIterationSettings::UNSYNCHRONIZED;
+                    } else if (method=="gaussSeidel") {
+                        valueIterationSettings.method = ValueIterationSettings::BLOCK_GAUSS_SEIDEL;
+                    } else if (method=="topological") {
+                        valueIterationSettings.method = ValueIterationSettings::TOPOLOGICAL;
+                    } else if (method=="distributed") {
+#ifdef USE_MPI
+                        valueIterationSettings.method = ValueIterationSettings::DISTRIBUTED;
+#else
+                        std::cerr << "Error: The value iteration method 'distributed' needs RAMPS to be built with MPI.\n";
+                        return 1;
+#endif
+                    } else {
+                        std::cerr << "Error: Unknown value iteration method '" << method << "'.\n";
+                        return 1;
+                    }
+                } else if (param=="--valueIterationCacheSize") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No parameter after '--valueIterationCacheSize'.\n";
+                        return 1;
+                    }
+                    std::istringstream is(args[++i]);
+                    is >> valueIterationCacheSize;
+                    if (is.fail()) {
+                        std::cerr << "Error: Illegal number after '--valueIterationCacheSize'.\n";
+                        return 1;
+                    }
+                } else if (param=="--nofParallelProbes") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No parameter after '--nofParallelProbes'.\n";
+                        return 1;
+                    }
+                    std::istringstream is(args[++i]);
+                    is >> nofParallelProbes;
+                    if ((is.fail()) || (nofParallelProbes==0)) {
+                        std::cerr << "Error: Illegal number after '--nofParallelProbes'.\n";
+                        return 1;
+                    }
+                } else if (param=="--convertToBinaryMDP") {
+                    convertToBinaryMDP = true;
+                } else if (param=="--binaryMDP") {
+                    inputFormat = MDP::BINARY_FILE;
+                } else if (param=="--bisimulation") {
+                    bisimulation = true;
+                } else if (param=="--binaryStrategy") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--binaryStrategy'.\n";
+                        return 1;
+                    }
+                    binaryStrategyFilename = args[++i];
+                } else if (param=="--stats") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--stats'.\n";
+                        return 1;
+                    }
+                    statisticsFilename = args[++i];
+                } else if (param=="--server") {
+                    serverMode = true;
+                } else if (param=="--socket") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--socket'.\n";
+                        return 1;
+                    }
+                    serverMode = true;
+                    socketPath = args[++i];
+                } else if (param=="--productCacheSize") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No parameter after '--productCacheSize'.\n";
+                        return 1;
+                    }
+                    std::istringstream is(args[++i]);
+                    is >> maxNofCachedProducts;
+                    if ((is.fail()) || (maxNofCachedProducts==0)) {
+                        std::cerr << "Error: Illegal number after '--productCacheSize'.\n";
+                        return 1;
+                    }
+                } else if (param=="--parity") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--parity'.\n";
+                        return 1;
+                    }
+                    parityPaths.push_back(args[++i]);
+                } else if (param=="--nofParallelSpecifications") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No parameter after '--nofParallelSpecifications'.\n";
+                        return 1;
+                    }
+                    std::istringstream is(args[++i]);
+                    is >> nofParallelSpecifications;
+                    if ((is.fail()) || (nofParallelSpecifications==0)) {
+                        std::cerr << "Error: Illegal number after '--nofParallelSpecifications'.\n";
+                        return 1;
+                    }
+                } else if (param=="--outputDirectory") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No directory name after '--outputDirectory'.\n";
+                        return 1;
+                    }
+                    outputDirectory = args[++i];
+                } else if (param=="--saveSolution") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--saveSolution'.\n";
+                        return 1;
+                    }
+                    saveSolutionFilename = args[++i];
+                } else if (param=="--previousModel") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name prefix after '--previousModel'.\n";
+                        return 1;
+                    }
+                    previousModelName = args[++i];
+                } else if (param=="--previousSolution") {
+                    if (nofArgs<=i+1) {
+                        std::cerr << "Error: No file name after '--previousSolution'.\n";
+                        return 1;
+                    }
+                    previousSolutionFilename = args[++i];
                 }
 
                 else {
@@ -63,123 +229,192 @@ int main(int nofArgs, const char **args) {
                     return 1;
                 }
             } else {
-                if (baseFilename=="") {
-                    baseFilename = args[i];
-                } else {
-                    std::cerr << "Error: More than one file name prefix given.\n";
-                    return 1;
-                }
+                baseFilenames.push_back(args[i]);
             }
         }
 
-        // Check basefilename
-        if (baseFilename=="") {
+        // Check basefilename. In server mode, the MDPs given are only read in advance.
+        if ((baseFilenames.size()==0) && !serverMode) {
             std::cerr << "Error: No input file name given.\n";
             return 1;
         }
+        if ((baseFilenames.size()>1) && !serverMode) {
+            std::cerr << "Error: More than one file name prefix given.\n";
+            return 1;
+        }
+        if (!serverMode) baseFilename = baseFilenames[0];
+
+        // Conversion mode: Only translate the MDP to a binary file
+        if (convertToBinaryMDP) {
+            const MDP mdp(baseFilename,inputFormat);
+            mdp.writeBinaryFile(baseFilename+".bmdp");
+            std::cerr << "Wrote binary MDP file " << baseFilename+".bmdp" << std::endl;
+            return 0;
+        }
+
+        if (valueIterationSettings.singlePrecision) {
+            std::cerr << "Using the " << getSinglePrecisionKernelName() << " kernel for single precision value iteration.\n";
+        }
 
         // Search strategy processing - including default setting
         if (searchStrategy=="") searchStrategy = "b:0.01:0.05";
-        std::vector<std::tuple<char,double,double> > searchStrategyParts;
-        {
-            std::stringstream ssA(searchStrategy);
-            std::string thisPart;
-            while (std::getline(ssA,thisPart,',')) {
-                std::stringstream ssB(thisPart);
-                std::string partA = "";
-                std::getline(ssB,partA,':');
-                if (partA=="b") {
-                    // Binary search
-                    double a;
-                    ssB >> a;
-                    char sep;
-                    ssB >> sep;
-                    if ((ssB.fail()) or (sep!=':')) {
-                        std::cerr << "Error: Illegal binary search string (1).\n";
-                        return 1;
-                    }
-                    double b;
-                    ssB >> b;
-                    if (ssB.bad()) {
-                        std::cerr << "Error: Illegal binary search string (2).\n";
-                        return 1;
-                    }
-                    searchStrategyParts.push_back(std::tuple<int,double,double>('b',a,b));
-                } else if (partA=="i") {
-                    // Incremental
-                    double a;
-                    ssB >> a;
-                    char sep;
-                    ssB >> sep;
-                    if ((ssB.fail()) or (sep!=':')) {
-                        std::cerr << "Error: Illegal incremental search string (1).\n";
-                        return 1;
-                    }
-                    double b;
-                    ssB >> b;
-                    if (ssB.bad()) {
-                        std::cerr << "Error: Illegal incremental search string (2).\n";
-                        return 1;
-                    }
-                    searchStrategyParts.push_back(std::tuple<int,double,double>('i',a,b));
-                } else {
-                    std::cerr << "Error: All strategy parts need to be 'b'inary search or 'i'ncremental: '" << partA << "'\n";
+        PolicySearchSettings policySearchSettings;
+        policySearchSettings.searchStrategy = parseSearchStrategy(searchStrategy);
+        policySearchSettings.minQuality = minQuality;
+        policySearchSettings.maxQuality = maxQuality;
+        policySearchSettings.valueIterationSettings = valueIterationSettings;
+        policySearchSettings.nofParallelProbes = nofParallelProbes;
+
+        // Distributed value iteration: All processes need to run the same value iteration calls one after the other
+        if (valueIterationSettings.method==ValueIterationSettings::DISTRIBUTED) {
+            if (serverMode || (parityPaths.size()>0)) {
+                std::cerr << "Error: The distributed value iteration method cannot be used in the server mode or for several parity automata.\n";
+                return 1;
+            }
+            if (valueIterationSettings.intervalIteration || valueIterationSettings.singlePrecision) {
+                std::cerr << "Error: The distributed value iteration method cannot be combined with '--intervalIteration' or '--singlePrecision'.\n";
+                return 1;
+            }
+            for (const SearchStrategyPart &part : policySearchSettings.searchStrategy) {
+                if (std::get<0>(part)=='k') {
+                    std::cerr << "Error: The 'k'-ary search cannot be used with the distributed value iteration method.\n";
                     return 1;
                 }
             }
+#ifdef USE_MPI
+            std::cerr << "Distributing value iteration over " << mpiEnvironment.getNofProcesses() << " MPI processes.\n";
+#endif
         }
 
-        // Start computation
-        const MDP mdp(baseFilename);
-        const ParityMDP parityMDP(baseFilename+".parity",mdp);
-        //parityMDP.dumpDot(std::cout);
-        std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash>,double> bestStrategy;
-        bestStrategy.second = 0.0;
-
-        for (const std::tuple<char,double,double> &currentSearchStrategyTuple : searchStrategyParts) {
-
-            double epsilon = std::get<2>(currentSearchStrategyTuple);
-
-            switch (std::get<0>(currentSearchStrategyTuple)) {
-            case 'i':
-            {
-                double mid = minQuality + std::get<1>(currentSearchStrategyTuple);
-                while (mid <= 1.0) {
-                    auto thisStrategy = parityMDP.computeRAPolicy(mid,epsilon,computePolicyEagerly);
-                    std::cerr << "Quality computed: " << thisStrategy.second << std::endl;
-                    if (thisStrategy.second>=mid) {
-                        minQuality = thisStrategy.second;
-                        mid = thisStrategy.second + std::get<1>(currentSearchStrategyTuple);
-                        bestStrategy = thisStrategy;
-                    } else {
-                        // Abort. Use "min" as signalizer
-                        mid = 2.0;
-                    }
-                }
+        // Reusing the results of an earlier run for a previous version of the MDP
+        if ((previousModelName=="")!=(previousSolutionFilename=="")) {
+            std::cerr << "Error: The parameters '--previousModel' and '--previousSolution' need to be given together.\n";
+            return 1;
+        }
+        if (((saveSolutionFilename!="") || (previousSolutionFilename!="")) && (serverMode || (parityPaths.size()>0) || (valueIterationCacheSize==0))) {
+            std::cerr << "Error: The parameters '--saveSolution' and '--previousSolution' cannot be used in the server mode, for several parity automata, or without the value iteration cache.\n";
+            return 1;
+        }
+
+        // Server mode: Answer requests until the input ends or the server is shut down
+        if (serverMode) {
+            if ((convertToBinaryMDP) || (binaryStrategyFilename!="") || (statisticsFilename!="")) {
+                std::cerr << "Error: The server mode cannot be combined with '--convertToBinaryMDP', '--binaryStrategy', or '--stats'.\n";
+                return 1;
             }
-                break;
-            case 'b':
-            {
-                while ((maxQuality-minQuality) > std::get<1>(currentSearchStrategyTuple)) {
-                    double mid = (maxQuality+minQuality)/2;
-                    auto thisStrategy = parityMDP.computeRAPolicy(mid,epsilon,computePolicyEagerly);
-                    std::cerr << "Quality computed: " << thisStrategy.second << ", asking for " << mid << std::endl;
-                    if (thisStrategy.second>=mid) {
-                        // foundStrategy
-                        minQuality = thisStrategy.second;
-                        bestStrategy = thisStrategy;
-                    } else {
-                        maxQuality = mid;
-                    }
-                }
+            SolverServer::Settings serverSettings;
+            serverSettings.policySearchSettings = policySearchSettings;
+            serverSettings.bisimulation = bisimulation;
+            serverSettings.inputFormat = inputFormat;
+            serverSettings.valueIterationCacheSize = valueIterationCacheSize;
+            serverSettings.maxNofCachedProducts = maxNofCachedProducts;
+            SolverServer server(serverSettings);
+            for (const std::string &modelName : baseFilenames) server.loadModel(modelName);
+            if (socketPath!="") {
+                server.serveUnixSocket(socketPath);
+            } else {
+                server.serve(std::cin,std::cout);
+            }
+            return 0;
+        }
+
+        // Batch mode: Read the MDP once and compute a policy for every parity automaton given
+        if (parityPaths.size()>0) {
+            if ((binaryStrategyFilename!="") || (statisticsFilename!="")) {
+                std::cerr << "Error: The parameters '--binaryStrategy' and '--stats' cannot be used for several parity automata.\n";
+                return 1;
             }
-                break;
-            default:
-                std::cerr << "Internal error in main.cpp,l." << __LINE__ << "\n";
+            const std::vector<std::string> parityFilenames = findParityFiles(parityPaths);
+            if (parityFilenames.size()==0) {
+                std::cerr << "Error: No parity automaton files found.\n";
                 return 1;
             }
+            BatchSettings batchSettings;
+            batchSettings.policySearchSettings = policySearchSettings;
+            batchSettings.bisimulation = bisimulation;
+            batchSettings.valueIterationCacheSize = valueIterationCacheSize;
+            batchSettings.nofParallelSpecifications = nofParallelSpecifications;
+            batchSettings.outputDirectory = outputDirectory;
+            const MDP mdp(baseFilename,inputFormat);
+            return solveBatch(mdp,parityFilenames,batchSettings)?0:1;
+        }
+
+        // Start computation
+        PerformanceStatistics statistics;
+        statistics.model = baseFilename;
+        PerformanceStatistics *stats = (statisticsFilename!="")?&statistics:NULL;
+        StopWatch phaseStopWatch;
+        const MDP mdp(baseFilename,inputFormat);
+        const ParityAutomaton parityAutomaton(baseFilename+".parity");
+        statistics.addPhase("parsing",phaseStopWatch);
+
+        // Optionally minimize the MDP before building the product
+        std::unique_ptr<MDP> quotientMDP;
+        BisimulationQuotientMapping quotientMapping;
+        if (bisimulation) {
+            phaseStopWatch = StopWatch();
+            std::vector<bool> relevantComponents;
+            std::vector<bool> relevantActions;
+            ParityMDP::findReferencedLabels(parityAutomaton,mdp,relevantComponents,relevantActions);
+            quotientMDP.reset(new MDP(mdp,relevantComponents,relevantActions,quotientMapping));
+            std::cerr << "Bisimulation quotient: " << quotientMDP->nofStates() << " of " << mdp.nofStates() << " states.\n";
+            statistics.addPhase("bisimulation",phaseStopWatch);
+        }
+
+        phaseStopWatch = StopWatch();
+        const ParityMDP parityMDP(parityAutomaton,bisimulation?*quotientMDP:mdp);
+        statistics.addPhase("product",phaseStopWatch);
+        //parityMDP.dumpDot(std::cout);
+        ValueIterationCache valueIterationCache(valueIterationCacheSize);
+        ValueIterationCache *cache = (valueIterationCacheSize>0)?&valueIterationCache:NULL;
+
+        // Optionally take over the results for a previous version of the MDP. Its product is built again, as the
+        // product states are identified by comparing the two products (as with "update" in the server mode).
+        if (previousSolutionFilename!="") {
+            phaseStopWatch = StopWatch();
+            const MDP previousMDP(previousModelName,inputFormat);
+            std::vector<unsigned int> previousBaseStates = mdp.findPreviousStates(previousMDP);
+            std::unique_ptr<MDP> previousQuotientMDP;
+            if (bisimulation) {
+                std::vector<bool> relevantComponents;
+                std::vector<bool> relevantActions;
+                BisimulationQuotientMapping previousQuotientMapping;
+                ParityMDP::findReferencedLabels(parityAutomaton,previousMDP,relevantComponents,relevantActions);
+                previousQuotientMDP.reset(new MDP(previousMDP,relevantComponents,relevantActions,previousQuotientMapping));
+                previousBaseStates = findPreviousQuotientStates(quotientMapping,previousQuotientMapping,previousBaseStates);
+            }
+            const ParityMDP previousParityMDP(parityAutomaton,bisimulation?*previousQuotientMDP:previousMDP);
+            ValueIterationCache previousCache(valueIterationCacheSize);
+            previousCache.readFile(previousSolutionFilename,parityAutomaton,previousParityMDP);
+            const std::vector<unsigned int> previousStates = parityMDP.findPreviousStates(previousParityMDP,previousBaseStates);
+            cache->setPreviousVersion(previousCache,previousStates);
+            std::cerr << "Reusing the results for the previous version of the MDP, with " << std::count(previousStates.begin(),previousStates.end(),(unsigned int)-1) << " of " << previousStates.size() << " product states changed.\n";
+            statistics.addPhase("previousSolution",phaseStopWatch);
+        }
+
+        phaseStopWatch = StopWatch();
+        const std::pair<Strategy,double> bestStrategy = parityMDP.searchRAPolicy(policySearchSettings,cache,stats,&std::cerr);
+        statistics.addPhase("policySearch",phaseStopWatch);
+        if (saveSolutionFilename!="") cache->writeFile(saveSolutionFilename,parityAutomaton,parityMDP);
+        phaseStopWatch = StopWatch();
+        if (bisimulation) {
+            std::vector<unsigned int> mdpStates;
+            const Strategy mappedStrategy = parityMDP.mapPolicyToOriginalMDP(bestStrategy.first,mdp,quotientMapping,mdpStates);
+            if (binaryStrategyFilename!="") {
+                mappedStrategy.writeBinaryFile(binaryStrategyFilename,mdpStates);
+            } else {
+                mappedStrategy.writeText(std::cout,mdpStates);
+            }
+        } else if (binaryStrategyFilename!="") {
+            parityMDP.writeBinaryPolicy(bestStrategy.first,binaryStrategyFilename);
+        } else {
+            parityMDP.printPolicy(bestStrategy.first);
+        }
+        statistics.addPhase("output",phaseStopWatch);
+        if (stats!=NULL) statistics.writeJSON(statisticsFilename);
+        if (cache!=NULL) {
+            std::cerr << "Value iteration results taken from the cache: " << cache->nofHits << " of " << cache->nofHits+cache->nofMisses << std::endl;
         }
-        parityMDP.printPolicy(bestStrategy.first);
         std::cerr << "Quality of the generated strategy: " << bestStrategy.second << std::endl;
 
     } catch (int error) {
@@ -191,6 +426,12 @@ int main(int nofArgs, const char **args) {
     } catch (const std::string error) {
         std::cerr << "Error: " << error << std::endl;
         return 1;
+    } catch (const std::bad_alloc &) {
+        std::cerr << "Error: Out of memory." << std::endl;
+        return 1;
+    } catch (const std::exception &error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
     }
 
 }
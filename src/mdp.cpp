@@ -1,215 +1,558 @@
 #include "mdp.hpp"
+#include "memoryMappedFile.hpp"
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <map>
 #include <set>
 #include <list>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+
+//=====================================================
+// Helper functions for parsing the memory-mapped
+// input files. All of them work on a position pointer
+// and the end of the file data and never read beyond
+// the end.
+//=====================================================
+namespace {
+
+inline bool isLineSpace(char c) {
+    return (c==' ') || (c=='\t') || (c=='\r');
+}
+
+inline void skipLineSpaces(const char *&pos, const char *end) {
+    while ((pos<end) && isLineSpace(*pos)) pos++;
+}
+
+inline const char *findLineEnd(const char *pos, const char *end) {
+    const char *lineEnd = static_cast<const char*>(memchr(pos,'\n',end-pos));
+    return (lineEnd==NULL)?end:lineEnd;
+}
+
+/**
+ * @brief Reads an unsigned integer. Returns false if there is none at the current position.
+ */
+inline bool parseUnsigned(const char *&pos, const char *end, unsigned int &result) {
+    if ((pos==end) || (*pos<'0') || (*pos>'9')) return false;
+    uint64_t value = 0;
+    while ((pos<end) && (*pos>='0') && (*pos<='9')) {
+        value = value*10 + (*pos-'0');
+        if (value>std::numeric_limits<unsigned int>::max()) return false;
+        pos++;
+    }
+    result = (unsigned int)value;
+    return true;
+}
 
 /**
- * @brief Reads an MDP from the three types of files generated by the Prism model checker
+ * @brief Reads a floating point number. Numbers with at most 15 significant digits and small exponents are
+ *        converted directly, which is exact as only one rounding step is needed. Other numbers are handed
+ *        to strtod.
+ */
+inline bool parseDouble(const char *&pos, const char *end, double &result) {
+    static const double powersOfTen[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    const char *start = pos;
+    while ((pos<end) && (((*pos>='0') && (*pos<='9')) || (*pos=='.') || (*pos=='e') || (*pos=='E') || (*pos=='-') || (*pos=='+'))) pos++;
+    if (pos==start) return false;
+
+    // Fast path
+    const char *current = start;
+    bool negative = false;
+    if ((*current=='-') || (*current=='+')) negative = (*(current++)=='-');
+    uint64_t mantissa = 0;
+    int nofSignificantDigits = 0;
+    int exponent = 0;
+    bool seenDigit = false;
+    while ((current<pos) && (*current>='0') && (*current<='9')) {
+        mantissa = mantissa*10 + (*current-'0');
+        if (mantissa>0) nofSignificantDigits++;
+        seenDigit = true;
+        current++;
+    }
+    if ((current<pos) && (*current=='.')) {
+        current++;
+        while ((current<pos) && (*current>='0') && (*current<='9')) {
+            mantissa = mantissa*10 + (*current-'0');
+            if (mantissa>0) nofSignificantDigits++;
+            exponent--;
+            seenDigit = true;
+            current++;
+        }
+    }
+    if ((current<pos) && ((*current=='e') || (*current=='E'))) {
+        current++;
+        bool negativeExponent = false;
+        if ((current<pos) && ((*current=='-') || (*current=='+'))) negativeExponent = (*(current++)=='-');
+        int explicitExponent = 0;
+        bool seenExponentDigit = false;
+        while ((current<pos) && (*current>='0') && (*current<='9') && (explicitExponent<10000)) {
+            explicitExponent = explicitExponent*10 + (*current-'0');
+            seenExponentDigit = true;
+            current++;
+        }
+        if (!seenExponentDigit) seenDigit = false;
+        exponent += negativeExponent?-explicitExponent:explicitExponent;
+    }
+    if (seenDigit && (current==pos) && (nofSignificantDigits<=15) && (exponent>=-22) && (exponent<=22)) {
+        double value = (double)mantissa;
+        if (exponent<0) {
+            value /= powersOfTen[-exponent];
+        } else {
+            value *= powersOfTen[exponent];
+        }
+        result = negative?-value:value;
+        return true;
+    }
+
+    // Slow path
+    char buffer[64];
+    if (pos-start>=(int)sizeof(buffer)) return false;
+    memcpy(buffer,start,pos-start);
+    buffer[pos-start] = 0;
+    char *parseEnd;
+    result = strtod(buffer,&parseEnd);
+    return parseEnd==buffer+(pos-start);
+}
+
+/**
+ * @brief Splits a string of the form "(a,b,c)" into its components
+ */
+void parseParenthesizedList(const char *pos, const char *end, std::vector<std::string> &components, const char *missingOpeningBraceError, const char *missingClosingBraceError) {
+    while ((end>pos) && (*(end-1)=='\r')) end--;
+    if ((pos==end) || (*pos!='(')) throw missingOpeningBraceError;
+    if (*(end-1)!=')') throw missingClosingBraceError;
+    pos++;
+    end--;
+    while (true) {
+        const char *separator = static_cast<const char*>(memchr(pos,',',end-pos));
+        if (separator==NULL) {
+            components.push_back(std::string(pos,end));
+            return;
+        }
+        components.push_back(std::string(pos,separator));
+        pos = separator+1;
+    }
+}
+
+/**
+ * @brief The contents of a consecutive block of lines of a transition file
+ */
+struct TransitionFileChunk {
+    std::vector<unsigned int> sourceStates;
+    std::vector<unsigned int> transitionNumbers;
+    std::vector<unsigned int> targetStates;
+    std::vector<double> probabilities;
+    std::vector<int> actions; // Indices into "actionNames", or -1 for none
+    std::vector<std::string> actionNames;
+    std::string error;
+};
+
+/**
+ * @brief Parses the lines of a transition file between "pos" and "end". Both need to be at the start of a line.
+ *        Errors are stored in the chunk rather than thrown, as this function is called in a parallel section.
+ */
+void parseTransitionFileChunk(const char *pos, const char *end, TransitionFileChunk &chunk) {
+    std::unordered_map<std::string,int> actionMapper;
+    size_t expectedNofLines = (end-pos)/16;
+    chunk.sourceStates.reserve(expectedNofLines);
+    chunk.transitionNumbers.reserve(expectedNofLines);
+    chunk.targetStates.reserve(expectedNofLines);
+    chunk.probabilities.reserve(expectedNofLines);
+    chunk.actions.reserve(expectedNofLines);
+    while (pos<end) {
+        const char *lineEnd = findLineEnd(pos,end);
+        skipLineSpaces(pos,lineEnd);
+        if (pos<lineEnd) {
+            unsigned int stateNr;
+            unsigned int transitionNumber;
+            unsigned int target;
+            double probability;
+            if (!parseUnsigned(pos,lineEnd,stateNr)) { chunk.error = "Error: Too short line in the transition file (1)"; return; }
+            skipLineSpaces(pos,lineEnd);
+            if (!parseUnsigned(pos,lineEnd,transitionNumber)) { chunk.error = "Error: Too short line in the transition file (2)"; return; }
+            skipLineSpaces(pos,lineEnd);
+            if (!parseUnsigned(pos,lineEnd,target)) { chunk.error = "Error: Too short line in the transition file (3)"; return; }
+            skipLineSpaces(pos,lineEnd);
+            if (!parseDouble(pos,lineEnd,probability)) { chunk.error = "Error: Too short line in the transition file (4)"; return; }
+            if ((pos<lineEnd) && !isLineSpace(*pos)) { chunk.error = "Error: Illegal number in the transition file."; return; }
+            skipLineSpaces(pos,lineEnd);
+            int action = -1;
+            if (pos<lineEnd) {
+                const char *labelStart = pos;
+                while ((pos<lineEnd) && !isLineSpace(*pos)) pos++;
+                std::string labelName(labelStart,pos);
+                auto it = actionMapper.find(labelName);
+                if (it==actionMapper.end()) {
+                    action = chunk.actionNames.size();
+                    actionMapper[labelName] = action;
+                    chunk.actionNames.push_back(labelName);
+                } else {
+                    action = it->second;
+                }
+                skipLineSpaces(pos,lineEnd);
+                if (pos<lineEnd) { chunk.error = "Error reading transition file line: line is too long."; return; }
+            }
+            chunk.sourceStates.push_back(stateNr);
+            chunk.transitionNumbers.push_back(transitionNumber);
+            chunk.targetStates.push_back(target);
+            chunk.probabilities.push_back(probability);
+            chunk.actions.push_back(action);
+        }
+        pos = lineEnd+1;
+    }
+}
+
+/**
+ * @brief A fixed-size hash table (with linear probing) that can be filled by several threads at the same time.
+ *        For every key, it keeps the smallest value inserted for it. This is used to find out which of several
+ *        threads discovered a new product state first (in a deterministic order).
+ */
+class ConcurrentMinimumTable {
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<std::atomic<uint64_t>[]> values;
+    uint64_t mask;
+    static inline uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+public:
+    static const uint64_t noEntry = (uint64_t)-1;
+    ConcurrentMinimumTable(uint64_t maxNofKeys) {
+        uint64_t size = 16;
+        while (size<2*maxNofKeys) size *= 2;
+        mask = size-1;
+        keys.reset(new std::atomic<uint64_t>[size]);
+        values.reset(new std::atomic<uint64_t>[size]);
+        #pragma omp parallel for
+        for (int64_t i=0;i<(int64_t)size;i++) {
+            keys[i].store(noEntry,std::memory_order_relaxed);
+            values[i].store(noEntry,std::memory_order_relaxed);
+        }
+    }
+    void insert(uint64_t key, uint64_t value) {
+        uint64_t slot = hash(key) & mask;
+        while (true) {
+            uint64_t slotKey = keys[slot].load(std::memory_order_relaxed);
+            if (slotKey==noEntry) {
+                if (keys[slot].compare_exchange_strong(slotKey,key)) slotKey = key;
+            }
+            if (slotKey==key) {
+                uint64_t old = values[slot].load();
+                while ((value<old) && !(values[slot].compare_exchange_weak(old,value))) {}
+                return;
+            }
+            slot = (slot+1) & mask;
+        }
+    }
+    uint64_t lookup(uint64_t key) const {
+        uint64_t slot = hash(key) & mask;
+        while (true) {
+            uint64_t slotKey = keys[slot].load(std::memory_order_relaxed);
+            if (slotKey==key) return values[slot].load();
+            if (slotKey==noEntry) return noEntry;
+            slot = (slot+1) & mask;
+        }
+    }
+};
+
+}
+
+/**
+ * @brief Sets the number of label components and clears the store. Must be called before adding states.
+ * @param nofComponents The number of components
+ * @param nofStates The number of states if the columns are set with "setComponent", and 0 otherwise
+ */
+void StateLabels::setNofComponents(unsigned int nofComponents, unsigned int nofStates) {
+    dictionaries.assign(nofComponents,std::vector<std::string>());
+    columns.assign(nofComponents,std::vector<uint32_t>());
+    valueNumbers.assign(nofComponents,std::unordered_map<std::string,uint32_t>());
+    nofStatesSoFar = nofStates;
+}
+
+/**
+ * @brief Adds the label of the next state, interning its values in the dictionaries.
+ * @param label The values of the label components
+ */
+void StateLabels::addState(const std::vector<std::string> &label) {
+    if (label.size()!=columns.size()) {
+        std::ostringstream error;
+        error << "Error in state file: State " << nofStatesSoFar << " has " << label.size() << " label components, but " << columns.size() << " were declared.";
+        throw error.str();
+    }
+    for (unsigned int i=0;i<label.size();i++) {
+        auto it = valueNumbers[i].find(label[i]);
+        if (it==valueNumbers[i].end()) {
+            it = valueNumbers[i].insert(std::make_pair(label[i],(uint32_t)dictionaries[i].size())).first;
+            dictionaries[i].push_back(label[i]);
+        }
+        columns[i].push_back(it->second);
+    }
+    nofStatesSoFar++;
+}
+
+/**
+ * @brief Sets the dictionary and column of a component at once (used when reading binary files). The column must
+ *        have one entry per state, and the entries must be valid value numbers for the dictionary.
+ * @param component The component number
+ * @param dictionary The distinct values - swapped into the store
+ * @param column The value number for every state - swapped into the store
+ */
+void StateLabels::setComponent(unsigned int component, std::vector<std::string> &dictionary, std::vector<uint32_t> &column) {
+    if (column.size()!=nofStatesSoFar) throw "Error: A column of the state labels has the wrong length.";
+    dictionaries[component].swap(dictionary);
+    columns[component].swap(column);
+}
+
+/**
+ * @brief Assembles the label of a state from the columns.
+ * @param state The state number
+ * @return The values of the label components
+ */
+std::vector<std::string> StateLabels::label(unsigned int state) const {
+    std::vector<std::string> result;
+    result.reserve(columns.size());
+    for (unsigned int i=0;i<columns.size();i++) result.push_back(dictionaries[i][columns[i][state]]);
+    return result;
+}
+
+/**
+ * @brief Reads an MDP from the three types of files generated by the Prism model checker. The files are
+ *        memory-mapped, and the transition file is parsed by all threads in parallel in chunks that are
+ *        split at line boundaries. Alternatively, the MDP can be read from a binary file written by "writeBinaryFile".
  * @param the file name without the suffix
+ * @param format Whether to read the PRISM files or the binary file
  */
-MDP::MDP(std::string baseFilename) {
+MDP::MDP(std::string baseFilename, InputFormat format) {
+
+    if (format==BINARY_FILE) {
+        readBinaryFile(baseFilename+".bmdp");
+        return;
+    }
 
     // Read state file
     {
-        std::ifstream stateFile(baseFilename+".sta");
+        MemoryMappedFile stateFile(baseFilename+".sta");
         if (stateFile.fail()) {
             std::cerr << "Error: Could not open state file " << baseFilename+".sta" << std::endl;
             throw 1;
         }
-        std::string labelLine;
-        std::getline(stateFile,labelLine);
-        if (stateFile.fail()) throw "Error: Empty label file.";
+        const char *pos = stateFile.begin();
+        const char *end = stateFile.end();
+        if (pos==end) throw "Error: Empty label file.";
         {
             // Parse label line
-            if (labelLine.at(0)!='(') throw "Illegal MDP state name pattern: no opening brace";
-            if (labelLine.at(labelLine.length()-1)!=')') throw "Illegal MDP state name pattern: no closing brace";
-            labelLine = labelLine.substr(1,labelLine.size()-2);
-            for (auto a = labelLine.find(","); a != std::string::npos;) {
-                // std::cerr << labelLine << "\n";
-                labelComponents.push_back(labelLine.substr(0,a));
-                labelLine = labelLine.substr(a+1,std::string::npos);
-                a = labelLine.find(",");
-            }
-            labelComponents.push_back(labelLine);
+            const char *lineEnd = findLineEnd(pos,end);
+            parseParenthesizedList(pos,lineEnd,labelComponents,"Illegal MDP state name pattern: no opening brace","Illegal MDP state name pattern: no closing brace");
+            labels.setNofComponents(labelComponents.size());
+            pos = lineEnd+1;
         }
 
-        std::string dataLine;
-        while (std::getline(stateFile,dataLine)) {
-            if (dataLine.length()>0) {
-                auto separator = dataLine.find(":");
-                if (separator==std::string::npos) {
+        while (pos<end) {
+            const char *lineEnd = findLineEnd(pos,end);
+            if (pos<lineEnd) {
+                const char *separator = static_cast<const char*>(memchr(pos,':',lineEnd-pos));
+                if (separator==NULL) {
                     throw "Error in state file: expected a ':' in a data line.";
                 }
-                std::istringstream isStateNumber(dataLine.substr(0,separator));
                 unsigned int stateNr;
-                isStateNumber >> stateNr;
-                if (isStateNumber.fail()) {
+                skipLineSpaces(pos,separator);
+                if (!parseUnsigned(pos,separator,stateNr)) {
                     throw "Error in state file: Could not read state number.";
                 }
-                if (stateNr != states.size()) {
+                if (stateNr != labels.nofStates()) {
                     std::ostringstream error;
-                    error << "Error in state file: Illegal state number in line '" << dataLine << "'";
+                    error << "Error in state file: Illegal state number in line '" << std::string(pos,lineEnd) << "'";
                     throw error.str();
                 }
 
                 // Parse the state label
                 std::vector<std::string> labelParts;
-                std::string label = dataLine.substr(separator+1,std::string::npos);
-                if (label.at(0)!='(') throw "Illegal MDP state name: no opening brace";
-                if (label.at(label.length()-1)!=')') throw "Illegal MDP state name: no closing brace";
-                label = label.substr(1,label.size()-2);
-                for (auto a = label.find(","); a != std::string::npos;) {
-                    labelParts.push_back(label.substr(0,a));
-                    label = label.substr(a+1,std::string::npos);
-                    a = label.find(",");
-                }
-                labelParts.push_back(label);
-                states.push_back(MDPState(labelParts));
+                labelParts.reserve(labelComponents.size());
+                parseParenthesizedList(separator+1,lineEnd,labelParts,"Illegal MDP state name: no opening brace","Illegal MDP state name: no closing brace");
+                labels.addState(labelParts);
             }
+            pos = lineEnd+1;
         }
-        transitions.resize(states.size());
+        labels.finishAddingStates();
     }
 
     // Read label file / initial state
     {
         initialState = (unsigned int)-1;
-        std::ifstream labelFile(baseFilename+".lab");
+        MemoryMappedFile labelFile(baseFilename+".lab");
         if (labelFile.fail()) {
             std::cerr << "Error: Could not open label file " << baseFilename+".lab" << std::endl;
             throw 1;
         }
-        std::string labelLine;
-        std::getline(labelFile,labelLine);
-        if (labelLine.substr(0,9)!="0=\"init\" ") {
+        const char *pos = labelFile.begin();
+        const char *end = labelFile.end();
+        const char *lineEnd = findLineEnd(pos,end);
+        if ((lineEnd-pos<9) || (strncmp(pos,"0=\"init\" ",9)!=0)) {
             throw "Error: Unexpected first line in the label line.";
         }
-        std::string dataLine;
-        while (std::getline(labelFile,dataLine)) {
-            if (dataLine.length()>0) {
-                auto separator = dataLine.find(": ");
-                if (separator==std::string::npos) {
+        pos = lineEnd+1;
+        while (pos<end) {
+            lineEnd = findLineEnd(pos,end);
+            if (pos<lineEnd) {
+                const char *lineStart = pos;
+                const char *separator = pos;
+                while ((separator+1<lineEnd) && ((separator[0]!=':') || (separator[1]!=' '))) separator++;
+                if (separator+1>=lineEnd) {
                     throw "Error in label file: expected a ':' in a data line.";
                 }
-                std::istringstream isStateNumber(dataLine.substr(0,separator));
                 unsigned int stateNr;
-                isStateNumber >> stateNr;
-                if (isStateNumber.fail()) {
+                skipLineSpaces(pos,separator);
+                if (!parseUnsigned(pos,separator,stateNr)) {
                     throw "Error in label file: Could not read state number.";
                 }
-                std::istringstream labelTypes(dataLine.substr(separator+2,std::string::npos));
-                int labelType;
-                while (labelTypes >> labelType) {
+                pos = separator+2;
+                skipLineSpaces(pos,lineEnd);
+                while (pos<lineEnd) {
+                    unsigned int labelType;
+                    if (!parseUnsigned(pos,lineEnd,labelType)) {
+                        std::ostringstream error;
+                        error << "Illegal label file line:\n" << std::string(lineStart,lineEnd);
+                        throw error.str();
+                    }
                     if (labelType==0) {
                         if (initialState==(unsigned int)-1)
                             initialState = stateNr;
                         else
                             throw "More than one initial state found.";
                     }
-                }
-                if (labelTypes.bad()) {
-                    std::ostringstream error;
-                    error << "Illegal label file line:\n" << dataLine;
-                    throw error.str();
+                    skipLineSpaces(pos,lineEnd);
                 }
             }
+            pos = lineEnd+1;
         }
     }
 
     // Read transitions
     {
-        std::ifstream transitionsFile(baseFilename+".tra");
+        MemoryMappedFile transitionsFile(baseFilename+".tra");
         if (transitionsFile.fail()) {
             std::cerr << "Error: Could not open label file " << baseFilename+".tra" << std::endl;
             throw 1;
         }
-        std::string numbersLine;
-        std::getline(transitionsFile,numbersLine);
-        unsigned int nofStates;
-        unsigned int nofTransitions;
-        unsigned int nofTransitionEdges;
-        std::istringstream isNumbersLine;
-        isNumbersLine >> nofStates;
-        isNumbersLine >> nofTransitions;
-        isNumbersLine >> nofTransitionEdges;
-        if (isNumbersLine.bad()) throw "Illegal numbers line in the transitions file.";
-
-        std::string dataLine;
-        MDPTransition *lastTransition = NULL;
+        const char *pos = transitionsFile.begin();
+        const char *end = transitionsFile.end();
+
+        // The numbers line is only used for pre-allocating memory
+        {
+            const char *lineEnd = findLineEnd(pos,end);
+            unsigned int nofStates = 0;
+            unsigned int nofTransitions = 0;
+            unsigned int nofTransitionEdges = 0;
+            skipLineSpaces(pos,lineEnd);
+            bool ok = parseUnsigned(pos,lineEnd,nofStates);
+            skipLineSpaces(pos,lineEnd);
+            ok = ok && parseUnsigned(pos,lineEnd,nofTransitions);
+            skipLineSpaces(pos,lineEnd);
+            ok = ok && parseUnsigned(pos,lineEnd,nofTransitionEdges);
+            if (!ok) throw "Illegal numbers line in the transitions file.";
+            // The numbers are only hints, so they are limited by the number of lines that fit into the file (with
+            // at least 8 characters per line)
+            const uint64_t maxNofLines = (uint64_t)(end-pos)/8+1;
+            auto limitedHint = [maxNofLines](unsigned int number) { return (size_t)std::min<uint64_t>(number,maxNofLines); };
+            transitions.stateOffsets.reserve(limitedHint(nofStates)+1);
+            transitions.choiceOffsets.reserve(limitedHint(nofTransitions)+1);
+            transitions.choiceActions.reserve(limitedHint(nofTransitions));
+            transitions.probabilities.reserve(limitedHint(nofTransitionEdges));
+            transitions.targets.reserve(limitedHint(nofTransitionEdges));
+            pos = (lineEnd<end)?lineEnd+1:end;
+        }
+
+        // Split the rest of the file into chunks at line boundaries and parse them in parallel
+        const size_t chunkSize = 1 << 23;
+        std::vector<const char *> chunkStarts;
+        chunkStarts.push_back(pos);
+        while (static_cast<size_t>(end-chunkStarts.back())>chunkSize) {
+            chunkStarts.push_back(std::min(findLineEnd(chunkStarts.back()+chunkSize,end)+1,end));
+        }
+        chunkStarts.push_back(end);
+        std::vector<TransitionFileChunk> chunks(chunkStarts.size()-1);
+        #pragma omp parallel for schedule(dynamic)
+        for (unsigned int i=0;i<chunks.size();i++) {
+            parseTransitionFileChunk(chunkStarts[i],chunkStarts[i+1],chunks[i]);
+        }
+
+        // Fill the transition relation in the order of the lines
+        std::unordered_map<std::string,int> actionMapper;
         unsigned int lastTransitionStartingState = (unsigned int)-1;
         unsigned int lastTransitionNumber = (unsigned int)-1;
-        while (std::getline(transitionsFile,dataLine)) {
-            if (dataLine.length()>0) {
-
-                // Split the line into pieces
-                std::istringstream isTransitionLine(dataLine);
-                unsigned int stateNr;
-                unsigned int transitionNumber;
-                unsigned int target;
-                double probability;
-                std::string labelName;
-                isTransitionLine >> stateNr;
-                if (isTransitionLine.fail()) throw "Error: Too short line in the transition file (1)";
-                isTransitionLine >> transitionNumber;
-                if (isTransitionLine.fail()) throw "Error: Too short line in the transition file (2)";
-                isTransitionLine >> target;
-                if (isTransitionLine.fail()) throw "Error: Too short line in the transition file (3)";
-                isTransitionLine >> probability;
-                if (isTransitionLine.fail()) throw "Error: Too short line in the transition file (4)";
-                isTransitionLine >> labelName;
-                if (isTransitionLine.fail()) {
-                    labelName = "";
-                }
-                std::string rest;
-                isTransitionLine >> rest;
-                if (!isTransitionLine.fail()) {
-                    throw "Error reading transition file line: line is too long.";
+        for (auto &chunk : chunks) {
+            if (chunk.error!="") throw chunk.error;
+
+            // Translate the action numbers of the chunk to the global ones
+            std::vector<int> chunkActionMapper;
+            for (auto &actionName : chunk.actionNames) {
+                auto it = actionMapper.find(actionName);
+                if (it==actionMapper.end()) {
+                    actionMapper[actionName] = actions.size();
+                    chunkActionMapper.push_back(actions.size());
+                    actions.push_back(actionName);
+                } else {
+                    chunkActionMapper.push_back(it->second);
                 }
+            }
+
+            for (unsigned int i=0;i<chunk.sourceStates.size();i++) {
+                const unsigned int stateNr = chunk.sourceStates[i];
+                const unsigned int transitionNumber = chunk.transitionNumbers[i];
+                if ((stateNr>=nofStates()) || (chunk.targetStates[i]>=nofStates())) throw "Error: Transition file refers to a state that is not in the state file.";
 
                 // New transition needed?
                 if ((lastTransitionStartingState!=stateNr) || (transitionNumber != lastTransitionNumber)) {
 
-                    // Allocate new transition
-                    if (transitionNumber!=transitions[stateNr].size()) throw "Error in transition number.";
-                    transitions[stateNr].push_back(MDPTransition());
-                    lastTransition = &(transitions[stateNr].back());
+                    // Allocate new transition. As the transitions are stored in compressed
+                    // sparse row format, they need to be sorted by starting state.
+                    if (stateNr+1<transitions.nofStates()) throw "Error: The transition file is not sorted by source state.";
+                    while (transitions.nofStates()<=stateNr) transitions.addState();
+                    if (transitionNumber!=transitions.nofChoices(stateNr)) throw "Error in transition number.";
                     lastTransitionStartingState = stateNr;
                     lastTransitionNumber = transitionNumber;
-
-                    // Check if there is a label....
-                    if (labelName!="") {
-                        // Old action?
-                        for (unsigned int i=0;i<actions.size();i++) {
-                            if (actions[i]==labelName) lastTransition->action = i;
-                        }
-                        // New action?
-                        if (lastTransition->action==-1) {
-                            lastTransition->action = actions.size();
-                            actions.push_back(labelName);
-                        }
-                    }
+                    transitions.addChoice((chunk.actions[i]==-1)?-1:chunkActionMapper[chunk.actions[i]]);
                 }
 
                 // Add an edge to the transition
-                lastTransition->edges.push_back(std::pair<double, unsigned int>(probability,target));
+                transitions.addEdge(chunk.probabilities[i],chunk.targetStates[i]);
             }
+
+            // Free the memory of the chunk early
+            chunk = TransitionFileChunk();
         }
+        while (transitions.nofStates()<nofStates()) transitions.addState();
     }
 
+    checkTransitions();
+}
+
+/**
+ * @brief Checks that the probabilities of every transition add up to 1, and warns about states that
+ *        are not reachable from the initial state
+ */
+void MDP::checkTransitions() const {
+
     // Check probabilities
-    for (unsigned int i=0;i<transitions.size();i++) {
-        auto &trA = transitions[i];
-        for (unsigned int j=0;j<trA.size();j++) {
-            auto &trB = trA[j];
+    for (unsigned int i=0;i<transitions.nofStates();i++) {
+        for (unsigned int j=transitions.choiceBegin(i);j<transitions.choiceEnd(i);j++) {
             double sum = 0.0;
-            for (auto &dat : trB.edges) {
-                sum += dat.first;
+            for (unsigned int k=transitions.edgeBegin(j);k<transitions.edgeEnd(j);k++) {
+                sum += transitions.probabilities[k];
             }
             if ((sum<0.999) || (sum>1.001)) {
                 std::ostringstream err;
-                err << "Sum of probabilities for transition " << j << " from state " << i << " adds up to probability " << sum;
+                err << "Sum of probabilities for transition " << j-transitions.choiceBegin(i) << " from state " << i << " adds up to probability " << sum;
                 throw err.str();
             }
         }
@@ -223,20 +566,18 @@ MDP::MDP(std::string baseFilename) {
     while (todo.size()>0) {
         unsigned int thisOne = todo.front();
         todo.pop_front();
-        for (auto &t : transitions[thisOne]) {
-            for (auto &e : t.edges) {
-                if (done.count(e.second)==0) {
-                    todo.push_back(e.second);
-                    done.insert(e.second);
-                }
+        for (unsigned int k=transitions.edgeBegin(transitions.choiceBegin(thisOne));k<transitions.edgeBegin(transitions.choiceEnd(thisOne));k++) {
+            if (done.count(transitions.targets[k])==0) {
+                todo.push_back(transitions.targets[k]);
+                done.insert(transitions.targets[k]);
             }
         }
     }
-    if (done.size()!=states.size()) {
-        std::cerr << "Warning: Found " << states.size()-done.size() << " unreadable states in the MDP!\n";
+    if (done.size()!=nofStates()) {
+        std::cerr << "Warning: Found " << nofStates()-done.size() << " unreadable states in the MDP!\n";
         std::cerr << "Examples state numbers are:";
         unsigned int statesPrinted = 0;
-        for (unsigned int i=0;i<states.size();i++) {
+        for (unsigned int i=0;i<nofStates();i++) {
             if (done.count(i)==0) {
                 if (statesPrinted<100) {
                     std::cerr << " " << i;
@@ -246,51 +587,46 @@ MDP::MDP(std::string baseFilename) {
         }
         std::cerr << std::endl;
     }
-
-
 }
 
 
 /**
- * @brief Constructor for a ParityMDP that is the product of an MDP and a Parity (word) automaton. The latter
- *        is assumed to have self-loops for all non-listed actions.
- * @param the parity automaton file name
- * @param the non-parity mdp
+ * @brief Reads a parity automaton file
+ * @param parityFilename The file name
  */
-ParityMDP::ParityMDP(std::string parityFilename, const MDP &baseMDP) {
-
-    // Copy basic info
-    actions = baseMDP.actions;
-
-    // Read parity automaton
+ParityAutomaton::ParityAutomaton(std::string parityFilename) {
     std::ifstream inFile(parityFilename);
     if (inFile.fail()) {
         std::ostringstream error;
         error << "Cannot open parity automaton file '" << parityFilename << "'.";
         throw error.str();
     }
-    // for (auto it : baseMDP.actions) {
-    //     std::cout << it << "\n";
-    // }
+    read(inFile);
+}
+
+/**
+ * @brief Reads a parity automaton in the format of the parity automaton files: a line with the colors of the
+ *        states, followed by one line "<from> <label> <to>" per transition.
+ * @param input The stream to read from
+ */
+void ParityAutomaton::read(std::istream &input) {
 
     // Parse color list
-    std::vector<unsigned int> parityColors;
     {
         std::string colorLine;
-        std::getline(inFile,colorLine);
+        std::getline(input,colorLine);
         std::istringstream is(colorLine);
         while (!(is >> std::ws).fail()) {
             unsigned int color;
             is >> color;
-            parityColors.push_back(color);
+            colors.push_back(color);
             if (is.bad()) throw "Error reading color line in Parity automaton";
         };
     }
 
     // Parse transitions
-    std::map<std::pair<unsigned int, std::string>,unsigned int> parityTransitions;
     std::string data;
-    while (std::getline(inFile,data)) {
+    while (std::getline(input,data)) {
         if (data.length()>0) {
             unsigned int from;
             std::string label;
@@ -312,130 +648,268 @@ ParityMDP::ParityMDP(std::string parityFilename, const MDP &baseMDP) {
             if (is.bad()) throw "Error: Illegal parity automaton line";
             is >> std::ws;
             if (!is.eof()) throw "Error: A parity automaton line is too long";
-
-            std::pair<unsigned int, std::string> data(from,label);
-            if (parityTransitions.count(data)>0) throw "Error: The parity automaton is non-deterministic.";
-            parityTransitions[data] = to;
+            addTransition(from,label,to);
         }
     }
+}
 
-    // Build product between the MDP and the parity automaton:
-    // 1. Initialize TODO list
-    struct TODOTuple {
-        unsigned int productState;
-        unsigned int mdpState;
-        unsigned int parityState;
-        TODOTuple(unsigned int pros, unsigned int mdps, unsigned int pars) : productState(pros), mdpState(mdps), parityState(pars) {}
+/**
+ * @brief Adds a transition to the automaton
+ * @param from The source state
+ * @param label The action name or the guard "component=value"
+ * @param to The target state
+ */
+void ParityAutomaton::addTransition(unsigned int from, const std::string &label, unsigned int to) {
+    std::pair<unsigned int, std::string> data(from,label);
+    if (transitions.count(data)>0) throw "Error: The parity automaton is non-deterministic.";
+    transitions[data] = to;
+}
+
+/**
+ * @brief Constructor for a ParityMDP that is the product of an MDP and a Parity (word) automaton. The latter
+ *        is assumed to have self-loops for all non-listed actions.
+ * @param the parity automaton
+ * @param the non-parity mdp
+ */
+ParityMDP::ParityMDP(const ParityAutomaton &automaton, const MDP &baseMDP) : baseLabels(baseMDP.labels) {
+
+    // Copy basic info
+    actions = baseMDP.actions;
+    const std::vector<unsigned int> &parityColors = automaton.colors;
+    const std::map<std::pair<unsigned int, std::string>,unsigned int> &parityTransitions = automaton.transitions;
+
+    // Compile the parity automaton transitions into tables, so that no strings need to be
+    // processed while building the product:
+    // - Action-labeled transitions are stored in a table indexed by parity state and action number.
+    // - Transitions labeled by "component=value" become guards with a component index and the number
+    //   of the value in the dictionary of the component (see "StateLabels").
+    // Guards are stored in the order of the "parityTransitions" map, and later matching guards take
+    // precedence. Errors in the guards of a parity state are only reported when the parity state is
+    // reached in the product, as before.
+    const unsigned int nofParityStates = parityColors.size();
+    struct Guard {
+        unsigned int component;
+        uint32_t value; // or (uint32_t)-1 if no MDP state has this value
+        unsigned int target;
     };
-    std::list<TODOTuple> todo;
-    std::map<std::pair<unsigned int /*mdpState*/, unsigned int /*parityState*/>, unsigned int /*productState*/> stateMapper;
-    todo.push_back(TODOTuple(0,baseMDP.initialState,0));
-    stateMapper[std::pair<unsigned int, unsigned int>(baseMDP.initialState,0)] = 0;
-    colors.push_back(parityColors[0]);
+    std::vector<std::vector<Guard> > guards(nofParityStates);
+    std::vector<std::string> guardErrors(nofParityStates);
+    std::vector<unsigned int> actionTargets(nofParityStates*actions.size(),(unsigned int)-1);
     {
-        std::vector<std::string> stateLabel = baseMDP.states[baseMDP.initialState].label;
-        stateLabel.push_back("0");
-        states.push_back(MDPState(stateLabel));
+        std::map<std::string,unsigned int> actionNumbers;
+        for (unsigned int i=0;i<actions.size();i++) actionNumbers[actions[i]] = i;
+        std::map<unsigned int,std::unordered_map<std::string,uint32_t> > valueNumbers; // Only for the components used
+        for (auto &a : parityTransitions) {
+            const unsigned int from = a.first.first;
+            const std::string &label = a.first.second;
+            if (from>=nofParityStates) continue; // Never reached, as the state has no color
+            auto action = actionNumbers.find(label);
+            if (action!=actionNumbers.end()) actionTargets[from*actions.size()+action->second] = a.second;
+            if (guardErrors[from]!="") continue;
+
+            if (label.find("=")!=std::string::npos) {
+                // This is a compound action -> interpret appropriately
+                std::string varName = label.substr(0,label.find("="));
+                std::string varValue = label.substr(label.find("=")+1,std::string::npos);
+
+                // Find state component
+                int index = -1;
+                for (unsigned int i=0;i<baseMDP.labelComponents.size();i++) {
+                    if (baseMDP.labelComponents[i]==varName) {
+                        index = i;
+                    }
+                }
+                if (index==-1) {
+                    std::ostringstream err; err << "Did not find key '" << varName << "'";
+                    guardErrors[from] = err.str();
+                    continue;
+                }
+                if (valueNumbers.count(index)==0) {
+                    auto &numbers = valueNumbers[index];
+                    const std::vector<std::string> &dictionary = baseLabels.dictionary(index);
+                    for (uint32_t i=0;i<dictionary.size();i++) numbers[dictionary[i]] = i;
+                }
+                auto value = valueNumbers[index].find(varValue);
+                Guard guard;
+                guard.component = index;
+                guard.value = (value==valueNumbers[index].end())?(uint32_t)-1:value->second;
+                guard.target = a.second;
+                guards[from].push_back(guard);
+            } else {
+                guardErrors[from] = "Action synchronization is currently not supported.";
+            }
+        }
     }
-    nofColors = parityColors[0];
-    initialState = 0;
-    nofColors = 0; // Will be increased during execution
 
-    // 2. Process TODO list
-    while (todo.size()>0) {
+    // Build product between the MDP and the parity automaton:
+    // 1. Initialize the mapping from (MDP state, parity state) pairs to product states. It is a dense
+    //    table if it is not too large, and a hash map otherwise. Product states are numbered in the order
+    //    in which a sequential breadth-first search finds them, and for each of them, the MDP state and
+    //    parity state are stored.
+    const uint64_t maxDenseStateMapperSize = 1 << 26;
+    const uint64_t nofStatePairs = (uint64_t)baseMDP.nofStates()*nofParityStates;
+    const bool denseStateMapper = nofStatePairs<=maxDenseStateMapperSize;
+    std::vector<unsigned int> denseStateMapperTable(denseStateMapper?nofStatePairs:0,(unsigned int)-1);
+    std::unordered_map<uint64_t,unsigned int> hashedStateMapper;
+    auto lookupProductState = [&](uint64_t pair) -> unsigned int {
+        if (denseStateMapper) return denseStateMapperTable[pair];
+        auto it = hashedStateMapper.find(pair);
+        return (it==hashedStateMapper.end())?(unsigned int)-1:it->second;
+    };
+    auto addProductState = [&](uint64_t pair) {
+        const unsigned int mdpState = pair/nofParityStates;
+        const unsigned int parityState = pair%nofParityStates;
+        if (denseStateMapper) {
+            denseStateMapperTable[pair] = toNonParityMDPMapper.size();
+        } else {
+            hashedStateMapper[pair] = toNonParityMDPMapper.size();
+        }
+        toNonParityMDPMapper.push_back(mdpState);
+        parityStates.push_back(parityState);
+        colors.push_back(parityColors[parityState]);
+        nofColors = std::max(nofColors,parityColors[parityState]);
+    };
+    if (nofParityStates==0) throw "Error: The parity automaton has no states.";
+    nofColors = 0; // Will be increased during execution
+    addProductState((uint64_t)baseMDP.initialState*nofParityStates);
+    initialState = 0;
 
-        TODOTuple thisItem = todo.front();
-        todo.pop_front();
-        //std::cerr << "todo"<< thisItem.mdpState << "," << thisItem.parityState << "," << thisItem.productState << std::endl;
-        while (transitions.size()<=thisItem.productState) transitions.push_back(std::vector<MDPTransition>());
-        toNonParityMDPMapper[thisItem.productState] = thisItem.mdpState;
-
-        // Iterate through the transitions
-        for (auto &tran : baseMDP.transitions[thisItem.mdpState]) {
-            MDPTransition targetTransition;
-            targetTransition.action = tran.action;
-
-            // Where does the parity
-            unsigned int parityTargetState;
-            if (tran.action!=-1) {
-                std::pair<unsigned int /*parityState*/, std::string /*action*/> parityEdge(thisItem.parityState,actions[tran.action]);
-                if (parityTransitions.count(parityEdge)==0) {
-                    parityTargetState = thisItem.parityState;
-                } else {
-                    parityTargetState = parityTransitions[parityEdge];
+    // 2. Process the product states level by level. The states of one level are expanded by all threads
+    //    in parallel. The successor states not seen before are collected in a concurrent hash table, which
+    //    finds for each of them the first edge (in the order of a sequential search) leading to it. This
+    //    way, the numbering of the product states does not depend on the number of threads.
+    unsigned int levelBegin = 0;
+    while (levelBegin<toNonParityMDPMapper.size()) {
+        const unsigned int levelEnd = toNonParityMDPMapper.size();
+
+        // Number the edges of the level. Errors in the guards are reported before expanding states in parallel.
+        std::vector<uint64_t> edgeOffsets(levelEnd-levelBegin+1,0);
+        for (unsigned int productState=levelBegin;productState<levelEnd;productState++) {
+            const unsigned int mdpState = toNonParityMDPMapper[productState];
+            const unsigned int nofEdges = baseMDP.transitions.edgeBegin(baseMDP.transitions.choiceEnd(mdpState))-baseMDP.transitions.edgeBegin(baseMDP.transitions.choiceBegin(mdpState));
+            if ((nofEdges>0) && (guardErrors[parityStates[productState]]!="")) throw guardErrors[parityStates[productState]];
+            edgeOffsets[productState-levelBegin+1] = edgeOffsets[productState-levelBegin]+nofEdges;
+        }
+        const uint64_t nofLevelEdges = edgeOffsets.back();
+
+        // Compute the successor (MDP state, parity state) pairs
+        std::vector<uint64_t> edgeTargetPairs(nofLevelEdges);
+        bool illegalParityTarget = false;
+        #pragma omp parallel for schedule(dynamic,256) reduction(||:illegalParityTarget)
+        for (unsigned int productState=levelBegin;productState<levelEnd;productState++) {
+            const unsigned int mdpState = toNonParityMDPMapper[productState];
+            const unsigned int parityState = parityStates[productState];
+            const std::vector<Guard> &theseGuards = guards[parityState];
+            uint64_t edgeNumber = edgeOffsets[productState-levelBegin];
+            for (unsigned int tran=baseMDP.transitions.choiceBegin(mdpState);tran<baseMDP.transitions.choiceEnd(mdpState);tran++) {
+                const int action = baseMDP.transitions.choiceActions[tran];
+
+                // Where does the parity automaton go for the action?
+                unsigned int parityTargetState = parityState;
+                if ((action!=-1) && (actionTargets[parityState*actions.size()+action]!=(unsigned int)-1)) {
+                    parityTargetState = actionTargets[parityState*actions.size()+action];
                 }
-            } else {
-                parityTargetState = thisItem.parityState;
-            }
 
-            // Iterate over the transitions
-            for (auto &edge : tran.edges) {
-
-                // Check if we have a new target parity state
-                unsigned int edgeParityTargetState = parityTargetState;
-
-                // If there is a '=' in the parity action name, then this refers to the state component
-                for (auto &a : parityTransitions) {
-                    if (a.first.first == thisItem.parityState) {
-                        if (a.first.second.find("=")!=std::string::npos) {
-
-                            // This is a compound action -> interpret appropriately
-                            std::string varName = a.first.second.substr(0,a.first.second.find("="));
-                            std::string varValue = a.first.second.substr(a.first.second.find("=")+1,std::string::npos);
-
-                            // Find state component
-                            int index = -1;
-                            for (unsigned int i=0;i<baseMDP.labelComponents.size();i++) {
-                                if (baseMDP.labelComponents[i]==varName) {
-                                    index = i;
-                                }
-                            }
-                            if (index==-1) {
-                                std::ostringstream err; err << "Did not find key '" << varName << "'";
-                                throw err.str();
-                            }
-                            if (varValue==baseMDP.states[edge.second].label[index]) {
-                                //std::cerr << "Found a complex edge match\n";
-                                edgeParityTargetState = a.second;
-                                //std::cout << "Dest: " << a.second << std::endl;
-                            }
-                        } else {
-                            throw "Action synchronization is currently not supported.";
+                for (unsigned int edge=baseMDP.transitions.edgeBegin(tran);edge<baseMDP.transitions.edgeEnd(tran);edge++) {
+                    const unsigned int edgeTarget = baseMDP.transitions.targets[edge];
+
+                    // Check if the target state satisfies a guard -> new target parity state
+                    unsigned int edgeParityTargetState = parityTargetState;
+                    for (auto it = theseGuards.rbegin();it!=theseGuards.rend();it++) {
+                        if (baseLabels.valueNumber(edgeTarget,it->component)==it->value) {
+                            edgeParityTargetState = it->target;
+                            break;
                         }
                     }
+                    if (edgeParityTargetState>=nofParityStates) illegalParityTarget = true;
+                    edgeTargetPairs[edgeNumber++] = (uint64_t)edgeTarget*nofParityStates+edgeParityTargetState;
                 }
+            }
+        }
+        if (illegalParityTarget) throw "Error: The parity automaton has a transition to a state without a color.";
 
-                std::pair<unsigned int /*mdpState*/, unsigned int /*parityState*/> target(edge.second,edgeParityTargetState);
-                if (stateMapper.count(target)==0) {
-                    stateMapper[target] = states.size();
-                    todo.push_back(TODOTuple(states.size(),edge.second,edgeParityTargetState));
-                    std::vector<std::string> stateLabel = baseMDP.states[edge.second].label;
-                    // std::cerr << "Prod: " << baseMDP.states[edge.second].label.size() << std::endl;
-                    std::ostringstream parityTargetString; parityTargetString << edgeParityTargetState;
-                    stateLabel.push_back(parityTargetString.str());
-                    states.push_back(MDPState(stateLabel));
-                    colors.push_back(parityColors.at(edgeParityTargetState));
-                    nofColors = std::max(nofColors,parityColors[edgeParityTargetState]);
-                }
+        // Find the first edge to every new successor pair
+        ConcurrentMinimumTable firstEdges(nofLevelEdges);
+        #pragma omp parallel for
+        for (int64_t edgeNumber=0;edgeNumber<(int64_t)nofLevelEdges;edgeNumber++) {
+            if (lookupProductState(edgeTargetPairs[edgeNumber])==(unsigned int)-1) firstEdges.insert(edgeTargetPairs[edgeNumber],edgeNumber);
+        }
 
-                targetTransition.edges.push_back(std::pair<double,unsigned int>(edge.first,stateMapper.at(target)));
+        std::vector<char> isFirstEdge(nofLevelEdges);
+        #pragma omp parallel for
+        for (int64_t edgeNumber=0;edgeNumber<(int64_t)nofLevelEdges;edgeNumber++) {
+            isFirstEdge[edgeNumber] = firstEdges.lookup(edgeTargetPairs[edgeNumber])==(uint64_t)edgeNumber;
+        }
+
+        // Number the new states in the order of their first edges
+        for (uint64_t edgeNumber=0;edgeNumber<nofLevelEdges;edgeNumber++) {
+            if (isFirstEdge[edgeNumber]) addProductState(edgeTargetPairs[edgeNumber]);
+        }
+
+        // Add the transitions of the level
+        for (unsigned int productState=levelBegin;productState<levelEnd;productState++) {
+            const unsigned int mdpState = toNonParityMDPMapper[productState];
+            transitions.addState();
+            uint64_t edgeNumber = edgeOffsets[productState-levelBegin];
+            for (unsigned int tran=baseMDP.transitions.choiceBegin(mdpState);tran<baseMDP.transitions.choiceEnd(mdpState);tran++) {
+                transitions.addChoice(baseMDP.transitions.choiceActions[tran]);
+                for (unsigned int edge=baseMDP.transitions.edgeBegin(tran);edge<baseMDP.transitions.edgeEnd(tran);edge++) {
+                    transitions.addEdge(baseMDP.transitions.probabilities[edge],lookupProductState(edgeTargetPairs[edgeNumber++]));
+                }
             }
+        }
+        levelBegin = levelEnd;
+    }
+}
 
-            transitions[thisItem.productState].push_back(targetTransition);
+/**
+ * @brief Finds the label components and actions of an MDP that a parity automaton refers to. Only these
+ *        need to be respected when the MDP is minimized before building the product.
+ * @param automaton The parity automaton
+ * @param baseMDP The MDP
+ * @param relevantComponents Is set to whether a guard of the automaton refers to the label component
+ * @param relevantActions Is set to whether the automaton has a transition for the action
+ */
+void ParityMDP::findReferencedLabels(const ParityAutomaton &automaton, const MDP &baseMDP, std::vector<bool> &relevantComponents, std::vector<bool> &relevantActions) {
+    relevantComponents.assign(baseMDP.labelComponents.size(),false);
+    relevantActions.assign(baseMDP.actions.size(),false);
+    for (auto &a : automaton.transitions) {
+        const std::string &label = a.first.second;
+        for (unsigned int i=0;i<baseMDP.actions.size();i++) {
+            if (baseMDP.actions[i]==label) relevantActions[i] = true;
+        }
+        if (label.find("=")!=std::string::npos) {
+            std::string varName = label.substr(0,label.find("="));
+            for (unsigned int i=0;i<baseMDP.labelComponents.size();i++) {
+                if (baseMDP.labelComponents[i]==varName) relevantComponents[i] = true;
+            }
         }
     }
 }
 
+/**
+ * @brief Computes the label of a product state, which is the label of its MDP state followed by the number
+ *        of its parity automaton state.
+ * @param state The product state number
+ * @return The values of the label components
+ */
+std::vector<std::string> ParityMDP::stateLabel(unsigned int state) const {
+    std::vector<std::string> result = baseLabels.label(toNonParityMDPMapper[state]);
+    std::ostringstream parityStateString; parityStateString << parityStates[state];
+    result.push_back(parityStateString.str());
+    return result;
+}
+
 /**
  * @brief Draws a parity MDP as DOT file.
  * @param output The output stream.
  */
 void ParityMDP::dumpDot(std::ostream &output) const {
     output << "digraph dotFile {\n";
-    for (unsigned int i=0;i<states.size();i++) {
+    for (unsigned int i=0;i<transitions.nofStates();i++) {
         output << "  s" << i << "[label=\"(";
         bool first = true;
-        for (auto a : states.at(i).label) {
+        for (auto a : stateLabel(i)) {
             if (first) {
                 first = false;
             } else {
@@ -446,14 +920,14 @@ void ParityMDP::dumpDot(std::ostream &output) const {
         output << ")\",shape=rectangle];\n";
     }
     unsigned int edgeID = 0;
-    for (unsigned int i=0;i<transitions.size();i++) {
-        for (unsigned int j=0;j<transitions[i].size();j++) {
+    for (unsigned int i=0;i<transitions.nofStates();i++) {
+        for (unsigned int j=transitions.choiceBegin(i);j<transitions.choiceEnd(i);j++) {
             output << "  e" << edgeID << "[label=\"\",size=0.05,fixedsize=true,shape=point];\n";
             output << "  s" << i << " -> e" << edgeID << "[label=\"";
-            if (transitions[i][j].action!=-1) output << actions[transitions[i][j].action];
+            if (transitions.choiceActions[j]!=-1) output << actions[transitions.choiceActions[j]];
             output << "\",dir=none];\n";
-            for (auto &edge : transitions[i][j].edges) {
-                output << "  e" << edgeID << " -> s" << edge.second << "[label=\"" << edge.first << "\"];\n";
+            for (unsigned int k=transitions.edgeBegin(j);k<transitions.edgeEnd(j);k++) {
+                output << "  e" << edgeID << " -> s" << transitions.targets[k] << "[label=\"" << transitions.probabilities[k] << "\"];\n";
             }
             edgeID++;
         }
@@ -5,85 +5,454 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <list>
+#include <cstdint>
+#include <algorithm>
+#include <tuple>
+#include "statistics.hpp"
 
-struct MDPState {
-    std::vector<std::string> label;
-    MDPState(std::vector<std::string> _label) : label(_label) {}
+/**
+ * @brief The labels of the states of an MDP in columnar form. For every label component, the distinct values are
+ *        stored once in a dictionary, and the column of the component contains the number of the value for every
+ *        state. While states are added, hash maps from the values to their numbers are kept, which can be freed
+ *        with "finishAddingStates".
+ */
+class StateLabels {
+    std::vector<std::vector<std::string> > dictionaries;
+    std::vector<std::vector<uint32_t> > columns;
+    std::vector<std::unordered_map<std::string,uint32_t> > valueNumbers;
+    unsigned int nofStatesSoFar;
+public:
+    StateLabels() : nofStatesSoFar(0) {}
+    void setNofComponents(unsigned int nofComponents, unsigned int nofStates = 0);
+    void addState(const std::vector<std::string> &label);
+    void setComponent(unsigned int component, std::vector<std::string> &dictionary, std::vector<uint32_t> &column);
+    void finishAddingStates() { valueNumbers.clear(); }
+    unsigned int nofStates() const { return nofStatesSoFar; }
+    unsigned int nofComponents() const { return columns.size(); }
+    uint32_t valueNumber(unsigned int state, unsigned int component) const { return columns[component][state]; }
+    const std::string &value(unsigned int state, unsigned int component) const { return dictionaries[component][columns[component][state]]; }
+    const std::vector<std::string> &dictionary(unsigned int component) const { return dictionaries[component]; }
+    const std::vector<uint32_t> &column(unsigned int component) const { return columns[component]; }
+    std::vector<std::string> label(unsigned int state) const;
+};
+
+/**
+ * @brief The transition relation of an MDP in compressed sparse row format. The transitions ("choices") of
+ *        state i are the ones numbered stateOffsets[i] to stateOffsets[i+1]-1, and the edges of choice j are
+ *        the ones numbered choiceOffsets[j] to choiceOffsets[j+1]-1. Edge probabilities and edge targets are
+ *        stored in separate arrays so that value iteration can run over them without any pointer chasing.
+ *
+ *        The relation is built state by state: "addState" starts the next state, "addChoice" appends a new
+ *        transition to the last state, and "addEdge" appends an edge to the last transition.
+ */
+struct TransitionMatrix {
+    std::vector<unsigned int> stateOffsets;
+    std::vector<unsigned int> choiceOffsets;
+    std::vector<int> choiceActions; // is -1 for transitions without an action
+    std::vector<double> probabilities;
+    std::vector<unsigned int> targets;
+
+    TransitionMatrix() : stateOffsets(1,0), choiceOffsets(1,0) {}
+
+    inline unsigned int nofStates() const { return stateOffsets.size()-1; }
+    inline unsigned int nofChoices(unsigned int state) const { return stateOffsets[state+1]-stateOffsets[state]; }
+    inline unsigned int choiceBegin(unsigned int state) const { return stateOffsets[state]; }
+    inline unsigned int choiceEnd(unsigned int state) const { return stateOffsets[state+1]; }
+    inline unsigned int edgeBegin(unsigned int choice) const { return choiceOffsets[choice]; }
+    inline unsigned int edgeEnd(unsigned int choice) const { return choiceOffsets[choice+1]; }
+    inline double probability(unsigned int edge) const { return probabilities[edge]; }
+    inline unsigned int target(unsigned int /* sourceState */, unsigned int edge) const { return targets[edge]; }
+
+    void addState() { stateOffsets.push_back(stateOffsets.back()); }
+    void addChoice(int action) {
+        choiceActions.push_back(action);
+        choiceOffsets.push_back(choiceOffsets.back());
+        stateOffsets.back()++;
+    }
+    void addEdge(double probability, unsigned int target) {
+        probabilities.push_back(probability);
+        targets.push_back(target);
+        choiceOffsets.back()++;
+    }
+};
+
+/**
+ * @brief A view on the transition relation of a parity MDP in which every state is copied. State i+n (for n
+ *        being the number of states of the parity MDP) is the second copy of state i. Whenever an odd color >
+ *        minGoalColor is visited, the run moves to the second ("backup") copy, and it never leaves the second
+ *        copy. The edges of the copies are computed on-the-fly from the original transitions and the colors,
+ *        so that the doubled transition relation never has to be built. The view offers the same interface
+ *        as a TransitionMatrix, except that it cannot be modified.
+ */
+struct BackupCopyTransitions {
+    const TransitionMatrix &base;
+    const std::vector<unsigned int> &colors;
+    const unsigned int minGoalColor;
+    const unsigned int nofBaseStates;
+
+    BackupCopyTransitions(const TransitionMatrix &_base, const std::vector<unsigned int> &_colors, unsigned int _minGoalColor) :
+        base(_base), colors(_colors), minGoalColor(_minGoalColor), nofBaseStates(_base.nofStates()) {}
+
+    inline bool isBackupTriggering(unsigned int baseState) const {
+        const unsigned int color = colors[baseState];
+        return ((color & 1)>0) && (color>minGoalColor);
+    }
+    inline unsigned int baseState(unsigned int state) const { return (state>=nofBaseStates)?(state-nofBaseStates):state; }
+
+    inline unsigned int nofStates() const { return 2*nofBaseStates; }
+    inline unsigned int nofChoices(unsigned int state) const { return base.nofChoices(baseState(state)); }
+    inline unsigned int choiceBegin(unsigned int state) const { return base.choiceBegin(baseState(state)); }
+    inline unsigned int choiceEnd(unsigned int state) const { return base.choiceEnd(baseState(state)); }
+    inline unsigned int edgeBegin(unsigned int choice) const { return base.edgeBegin(choice); }
+    inline unsigned int edgeEnd(unsigned int choice) const { return base.edgeEnd(choice); }
+    inline double probability(unsigned int edge) const { return base.probabilities[edge]; }
+    inline unsigned int target(unsigned int sourceState, unsigned int edge) const {
+        const unsigned int t = base.targets[edge];
+        if ((sourceState>=nofBaseStates) || isBackupTriggering(t)) return t+nofBaseStates;
+        return t;
+    }
 };
 
-struct MDPTransition {
-    int action;
-    std::vector<std::pair<double, unsigned int> > edges;
-    MDPTransition() : action(-1) {}
+/**
+ * @brief A set of states of an MDP with states 0 to nofStates-1, stored as a bitset. Membership tests take constant
+ *        time, and the states are enumerated in increasing order. "assignIf" builds the set in parallel, as every
+ *        thread fills whole 64-bit words.
+ */
+class StateSet {
+private:
+    std::vector<uint64_t> words;
+    unsigned int nofStatesInUniverse;
+    unsigned int nofElements;
+    void recount() {
+        uint64_t count = 0;
+        for (uint64_t word : words) count += __builtin_popcountll(word);
+        nofElements = count;
+    }
+public:
+    StateSet(unsigned int nofStates = 0) : words((nofStates+63)/64,0), nofStatesInUniverse(nofStates), nofElements(0) {}
+    inline unsigned int nofStates() const { return nofStatesInUniverse; }
+    inline unsigned int size() const { return nofElements; }
+    inline bool contains(unsigned int state) const { return (words[state/64] >> (state % 64)) & 1; }
+    inline void insert(unsigned int state) {
+        if (!contains(state)) nofElements++;
+        words[state/64] |= (uint64_t)1 << (state % 64);
+    }
+    inline void erase(unsigned int state) {
+        if (contains(state)) nofElements--;
+        words[state/64] &= ~((uint64_t)1 << (state % 64));
+    }
+    void insertAll(const StateSet &other) {
+        for (unsigned int w=0;w<words.size();w++) words[w] |= other.words[w];
+        recount();
+    }
+    template<class Predicate> void assignIf(const Predicate &predicate) {
+        #pragma omp parallel for schedule(static)
+        for (unsigned int w=0;w<words.size();w++) {
+            uint64_t word = 0;
+            for (unsigned int i=w*64;(i<(w+1)*64) && (i<nofStatesInUniverse);i++) {
+                if (predicate(i)) word |= (uint64_t)1 << (i % 64);
+            }
+            words[w] = word;
+        }
+        recount();
+    }
+    template<class Predicate> void eraseIf(const Predicate &predicate) {
+        #pragma omp parallel for schedule(static)
+        for (unsigned int w=0;w<words.size();w++) {
+            uint64_t word = words[w];
+            for (uint64_t rest = word;rest!=0;rest &= rest-1) {
+                const unsigned int i = w*64+__builtin_ctzll(rest);
+                if (predicate(i)) word &= ~((uint64_t)1 << (i % 64));
+            }
+            words[w] = word;
+        }
+        recount();
+    }
+    template<class Function> void forEach(const Function &function) const {
+        for (unsigned int w=0;w<words.size();w++) {
+            for (uint64_t rest = words[w];rest!=0;rest &= rest-1) function(w*64+__builtin_ctzll(rest));
+        }
+    }
+    std::vector<unsigned int> toVector() const {
+        std::vector<unsigned int> result;
+        result.reserve(nofElements);
+        forEach([&result](unsigned int state) { result.push_back(state); });
+        return result;
+    }
+};
+
+/**
+ * @brief The values of the states whose values are fixed during value iteration (e.g., goal states), stored densely
+ *        for all states of an MDP, so that they can be looked up in constant time.
+ */
+class FixedValues {
+private:
+    std::vector<double> values; // Is -1.0 for the states whose values are not fixed
+public:
+    FixedValues(unsigned int nofStates = 0) : values(nofStates,-1.0) {}
+    inline unsigned int nofStates() const { return values.size(); }
+    inline bool isFixed(unsigned int state) const { return values[state]>=0.0; }
+    inline double value(unsigned int state) const { return values[state]; }
+    inline void set(unsigned int state, double value) { values[state] = value; }
+    void clear() { std::fill(values.begin(),values.end(),-1.0); }
 };
 
+/**
+ * @brief Parameters of the value iteration procedure
+ */
+struct ValueIterationSettings {
+    enum Method {
+        UNSYNCHRONIZED, // All threads update the values in-place without synchronization
+        BLOCK_GAUSS_SEIDEL, // Deterministic Gauss-Seidel updates within blocks of states
+        TOPOLOGICAL, // Value iteration SCC by SCC in reverse topological order
+        DISTRIBUTED // Every MPI process updates a slice of the states (only if built with MPI)
+    };
+    double epsilon; // The cutoff value for value iteration
+    bool computePolicyEagerly;
+    Method method;
+    bool intervalIteration; // Also compute upper bounds and stop when they are close enough to the values
+    bool qualitativePrecomputation; // Find the states with values 0 and 1 by graph analysis first
+    bool singlePrecision; // Compute lower bounds with single precision (vectorized) value iteration first
+    bool warmStart; // Start the rounds of the inner fixpoint from the values of the previous round (from above)
+    ValueIterationSettings() : epsilon(0.05), computePolicyEagerly(false), method(UNSYNCHRONIZED), intervalIteration(false), qualitativePrecomputation(true), singlePrecision(false), warmStart(false) {}
+};
+
+/**
+ * @brief Relates the states and choices of an MDP to those of its bisimulation quotient (see the quotient constructor of "MDP")
+ */
+struct BisimulationQuotientMapping {
+    std::vector<unsigned int> quotientStates; // The quotient state of every state of the original MDP
+    std::vector<unsigned int> quotientChoices; // For every choice of the original MDP: the number of the corresponding choice of its quotient state
+};
+
+std::vector<unsigned int> findPreviousQuotientStates(const BisimulationQuotientMapping &mapping, const BisimulationQuotientMapping &previousMapping, const std::vector<unsigned int> &previousStates);
+
 struct MDP {
     std::vector<std::string> actions;
     std::vector<std::string> labelComponents;
-    std::vector<MDPState> states;
-    std::vector<std::vector<MDPTransition> > transitions;
+    StateLabels labels;
+    TransitionMatrix transitions;
     unsigned int initialState; // is (unsigned int)-1 if undefined
 
+    unsigned int nofStates() const { return labels.nofStates(); }
+
+    enum InputFormat {
+        PRISM_FILES, // .sta/.lab/.tra files
+        BINARY_FILE // .bmdp file written by "writeBinaryFile"
+    };
+
     MDP() : initialState(-1) {}
-    MDP(std::string baseFilename);
+    MDP(std::string baseFilename, InputFormat format = PRISM_FILES);
+    MDP(const MDP &original, const std::vector<bool> &relevantComponents, const std::vector<bool> &relevantActions, BisimulationQuotientMapping &mapping);
+    void writeBinaryFile(std::string filename) const;
+    void checkTransitions() const;
+    std::vector<unsigned int> findPreviousStates(const MDP &previous) const;
+private:
+    void readBinaryFile(std::string filename);
+public:
 
-    std::vector<std::pair<double,unsigned int> > valueIteration(const std::map<unsigned int, double> &fixedValues, double epsilon, bool computePolicyEagerly) const;
+    std::vector<std::pair<double,unsigned int> > valueIteration(const FixedValues &fixedValues, const ValueIterationSettings &settings, const std::vector<std::pair<double,unsigned int> > *initialValues = NULL, bool initialValuesAreUpperBounds = false) const;
 
 };
 
+/**
+ * @brief Builds an MDP in memory, so that programs that generate MDPs do not have to write the PRISM files first.
+ *        States are added in the order of their numbers with "addState". "addChoice" appends a new transition to
+ *        the last state added, and "addEdge" appends an edge to the last transition. Edges may lead to states that
+ *        are only added later. "build" checks the MDP in the same way as the PRISM file parser does and hands it
+ *        over; the builder must not be used afterwards.
+ */
+class MDPBuilder {
+private:
+    MDP mdp;
+    std::unordered_map<std::string,int> actionNumbers;
+public:
+    MDPBuilder(const std::vector<std::string> &labelComponents);
+    unsigned int nofStates() const { return mdp.nofStates(); }
+    unsigned int nofLabelComponents() const { return mdp.labelComponents.size(); }
+    unsigned int addState(const std::vector<std::string> &label);
+    void addChoice(const std::string &action = "");
+    void addEdge(unsigned int target, double probability);
+    void setInitialState(unsigned int state) { mdp.initialState = state; }
+    MDP build();
+};
 
 /**
- * @brief This struct captures the precondition in a transition in the generated strategy. It is basically the look-up type for the map implementing the strategy
+ * @brief A deterministic parity automaton over the runs of an MDP. State i of the automaton has the color colors[i].
+ *        The transitions are indexed by the source state and a label, which is either the name of an action of the
+ *        MDP or a guard of the form "component=value" over the label of the next MDP state. For all other actions
+ *        and labels, the automaton stays in its state.
  */
-struct StrategyTransitionPredecessor{
-    unsigned int mdpState;
-    unsigned int dataState;
-    StrategyTransitionPredecessor(unsigned int _mdpState,unsigned int _dataState) : mdpState(_mdpState), dataState(_dataState) {}
-
-    bool operator<(const StrategyTransitionPredecessor &other) const {
-        int v1 = ((int)mdpState)-((int)other.mdpState);
-        if (v1<0) return true;
-        if (v1>0) return false;
-        return ((int)dataState)-((int)other.dataState)<0;
-    }
+struct ParityAutomaton {
+    std::vector<unsigned int> colors;
+    std::map<std::pair<unsigned int, std::string>,unsigned int> transitions;
 
-    bool operator==(const StrategyTransitionPredecessor &other) const {
-        return (other.mdpState==mdpState) && (other.dataState==dataState);
-    }
+    ParityAutomaton() {}
+    ParityAutomaton(std::string parityFilename);
+    void read(std::istream &input);
+    void addState(unsigned int color) { colors.push_back(color); }
+    void addTransition(unsigned int from, const std::string &label, unsigned int to);
+    uint64_t fingerprint() const;
 };
 
-struct StrategyTransitionPredecessorHash {
-    inline std::size_t operator()(const StrategyTransitionPredecessor& k) const {
-        return (size_t)(k.mdpState)*1337 ^ (size_t)(k.dataState*23);
+
+/**
+ * @brief An RA policy in a flat representation. Every entry consists of a product state and a data state (the memory
+ *        of the policy), the chosen action (as number of the choice of the state), and the memory updates, which map the
+ *        successor states to their data states. The entries and memory updates are stored in contiguous arrays; the
+ *        memory updates of entry i are the updates updateBegin(i) to updateEnd(i)-1.
+ *
+ *        A strategy is built by calling "addEntry", then "addMemoryUpdate" for its successor states, and "finishEntry".
+ *        If a memory update is given twice for the same successor state, or an entry twice for the same state and data
+ *        state, the last one counts. "finalize" has to be called afterwards. It sorts the entries by their data states
+ *        and states, so that "findEntry" can search for them.
+ */
+class Strategy {
+private:
+    std::vector<unsigned int> entryStates;
+    std::vector<unsigned int> entryDataStates;
+    std::vector<unsigned int> entryActions;
+    std::vector<unsigned int> updateOffsets;
+    std::vector<unsigned int> updateStates;
+    std::vector<unsigned int> updateDataStates;
+    std::vector<bool> statesWithInitialDataEntry; // While the strategy is built: the states with an entry for data state 0
+public:
+    Strategy(unsigned int nofStates = 0) : updateOffsets(1,0), statesWithInitialDataEntry(nofStates,false) {}
+    bool hasInitialDataEntry(unsigned int state) const { return statesWithInitialDataEntry[state]; }
+    void addEntry(unsigned int state, unsigned int dataState, unsigned int action);
+    void addMemoryUpdate(unsigned int state, unsigned int dataState) {
+        updateStates.push_back(state);
+        updateDataStates.push_back(dataState);
     }
+    void finishEntry();
+    void finalize();
+
+    unsigned int nofEntries() const { return entryStates.size(); }
+    unsigned int state(unsigned int entry) const { return entryStates[entry]; }
+    unsigned int dataState(unsigned int entry) const { return entryDataStates[entry]; }
+    unsigned int action(unsigned int entry) const { return entryActions[entry]; }
+    unsigned int updateBegin(unsigned int entry) const { return updateOffsets[entry]; }
+    unsigned int updateEnd(unsigned int entry) const { return updateOffsets[entry+1]; }
+    unsigned int updateState(unsigned int update) const { return updateStates[update]; }
+    unsigned int updateDataState(unsigned int update) const { return updateDataStates[update]; }
+    unsigned int findEntry(unsigned int state, unsigned int dataState) const;
+
+    void writeText(std::ostream &output, const std::vector<unsigned int> &mdpStates) const;
+    void writeBinaryFile(std::string filename, const std::vector<unsigned int> &mdpStates) const;
+};
+
+
+struct ParityMDP;
+
+/**
+ * @brief A cache for the results of the value iteration calls in ParityMDP::computeRAPolicy. Every value iteration
+ *        problem there only depends on the goal color, the current goal states, the winning goal states found
+ *        before, and the value iteration settings, but not on the RA level. When computeRAPolicy is called for
+ *        several RA levels (e.g., during a binary search), the results can thus be reused. A cache object must
+ *        only be used for one parity MDP. When the cache is full, the least recently used results are dropped.
+ *        The cache can be used by several threads at the same time.
+ *
+ *        When the MDP changes in a few states, the results for the previous version of the parity MDP can be
+ *        handed over to the cache for the new version with "setPreviousVersion". They are not valid for the new
+ *        version, but "lookupPreviousVersion" finds the one for the most similar problem, so that value iteration
+ *        only needs to update the states whose values may have changed (see "fixValuesOfUnaffectedStates").
+ */
+class ValueIterationCache {
+public:
+    struct Key {
+        unsigned int minGoalColor; // is (unsigned int)-1 for the final value iteration towards the winning goal states
+        std::vector<unsigned int> goalStates;
+        std::vector<unsigned int> winningStates;
+        double epsilon;
+        bool computePolicyEagerly;
+        ValueIterationSettings::Method method;
+        bool intervalIteration;
+        bool singlePrecision;
+        bool warmStart;
+        bool operator==(const Key &other) const {
+            return (minGoalColor==other.minGoalColor) && (epsilon==other.epsilon) && (computePolicyEagerly==other.computePolicyEagerly)
+                && (method==other.method) && (intervalIteration==other.intervalIteration) && (singlePrecision==other.singlePrecision)
+                && (warmStart==other.warmStart)
+                && (goalStates==other.goalStates) && (winningStates==other.winningStates);
+        }
+    };
+private:
+    struct Entry {
+        Key key;
+        std::vector<std::pair<double,unsigned int> > values;
+        std::vector<double> upperBounds; // Only with interval iteration
+        size_t sizeInBytes() const { return values.size()*sizeof(std::pair<double,unsigned int>)+upperBounds.size()*sizeof(double); }
+    };
+    std::list<Entry> entries; // Most recently used entry first
+    size_t maxCachedBytes;
+    size_t nofCachedBytes;
+    std::vector<Entry> previousVersionEntries; // The results for the previous version of the parity MDP, in the current state numbers
+    std::vector<char> changedStates; // The states without an unchanged counterpart in the previous version
+public:
+    unsigned long nofHits;
+    unsigned long nofMisses;
+    ValueIterationCache(size_t maxSizeInMB) : maxCachedBytes(maxSizeInMB*1024*1024), nofCachedBytes(0), nofHits(0), nofMisses(0) {}
+    bool lookup(const Key &key, std::vector<std::pair<double,unsigned int> > &values, std::vector<double> *upperBounds = NULL);
+    void insert(const Key &key, const std::vector<std::pair<double,unsigned int> > &values, const std::vector<double> *upperBounds = NULL);
+    void setPreviousVersion(const ValueIterationCache &previous, const std::vector<unsigned int> &previousStates);
+    bool hasPreviousVersion() const { return !previousVersionEntries.empty(); }
+    bool lookupPreviousVersion(const Key &key, std::vector<std::pair<double,unsigned int> > &values, std::vector<char> &differingStates) const;
+    void writeFile(std::string filename, const ParityAutomaton &automaton, const ParityMDP &parityMDP) const;
+    void readFile(std::string filename, const ParityAutomaton &automaton, const ParityMDP &parityMDP);
 };
 
-struct StrategyTransitionChoice {
-    unsigned int action;
-    std::map<unsigned int /* mdpstate */, unsigned int /* dataState */> memoryUpdate;
-    StrategyTransitionChoice() : action((unsigned int)-1) {}
-    StrategyTransitionChoice(unsigned int _action) : action(_action) {}
-    StrategyTransitionChoice(unsigned int _action, const std::map<unsigned int /* mdpstate */, unsigned int /* dataState */> &_memoryUpdate) : action(_action), memoryUpdate(_memoryUpdate) {}
+
+/**
+ * @brief One part of a search strategy for the best RA level: the kind of search ('b'inary, 'k'-ary, or
+ *        'i'ncremental), the precision of the search (for 'i': the step size), and the value iteration threshold
+ */
+typedef std::tuple<char,double,double> SearchStrategyPart;
+
+std::vector<SearchStrategyPart> parseSearchStrategy(const std::string &searchStrategy);
+
+/**
+ * @brief Parameters of the search for the RA policy with the highest RA level (see ParityMDP::searchRAPolicy)
+ */
+struct PolicySearchSettings {
+    std::vector<SearchStrategyPart> searchStrategy;
+    double minQuality;
+    double maxQuality;
+    ValueIterationSettings valueIterationSettings; // The threshold "epsilon" is taken from the search strategy parts
+    unsigned int nofParallelProbes; // for the 'k'-ary search
+    PolicySearchSettings() : searchStrategy(parseSearchStrategy("b:0.01:0.05")), minQuality(0.0), maxQuality(1.0), nofParallelProbes(4) {}
 };
 
 
 struct ParityMDP {
 private:
     std::vector<std::string> actions;
-    std::vector<MDPState> states;
-    std::vector<std::vector<MDPTransition> > transitions;
+    const StateLabels &baseLabels; // The labels of the MDP states - shared with the MDP
+    TransitionMatrix transitions;
     std::vector<unsigned int> colors;
-    std::map<unsigned int,unsigned int> toNonParityMDPMapper;
+    std::vector<unsigned int> toNonParityMDPMapper; // The MDP state for every product state
+    std::vector<unsigned int> parityStates; // The parity automaton state for every product state
     unsigned int initialState; // is always 0
     unsigned int nofColors;
 
 
 
 public:
-    ParityMDP(std::string parityFilename, const MDP &baseMDP);
+    ParityMDP(const ParityAutomaton &automaton, const MDP &baseMDP);
+    ParityMDP(std::string parityFilename, const MDP &baseMDP) : ParityMDP(ParityAutomaton(parityFilename),baseMDP) {}
+    static void findReferencedLabels(const ParityAutomaton &automaton, const MDP &baseMDP, std::vector<bool> &relevantComponents, std::vector<bool> &relevantActions);
+    unsigned int nofStates() const { return transitions.nofStates(); }
+    unsigned int nofEdges() const { return transitions.targets.size(); }
+    const std::vector<unsigned int> &mdpStates() const { return toNonParityMDPMapper; }
+    std::vector<unsigned int> findPreviousStates(const ParityMDP &previous, const std::vector<unsigned int> &previousMDPStates) const;
+    uint64_t fingerprint() const;
+    std::vector<std::string> stateLabel(unsigned int state) const;
     void dumpDot(std::ostream &output) const;
-    std::pair<std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash>,double> computeRAPolicy(double raLevel, double epsilon, bool computePolicyEagerly) const;
-    void printPolicy(const std::unordered_map<StrategyTransitionPredecessor,StrategyTransitionChoice,StrategyTransitionPredecessorHash> &policy) const;
+    std::pair<Strategy,double> computeRAPolicy(double raLevel, const ValueIterationSettings &settings, ValueIterationCache *cache = NULL, ProbeStatistics *statistics = NULL, std::ostream *log = NULL) const;
+    std::pair<Strategy,double> searchRAPolicy(const PolicySearchSettings &settings, ValueIterationCache *cache = NULL, PerformanceStatistics *statistics = NULL, std::ostream *log = NULL) const;
+    void printPolicy(const Strategy &policy) const;
+    void writeBinaryPolicy(const Strategy &policy, std::string filename) const;
+    Strategy mapPolicyToOriginalMDP(const Strategy &policy, const MDP &originalMDP, const BisimulationQuotientMapping &mapping, std::vector<unsigned int> &mdpStates) const;
 };
 
 
@@ -0,0 +1,87 @@
+#include "mdp.hpp"
+#include <sstream>
+
+//=====================================================
+// Building MDPs in memory
+//
+// The builder fills the same data structures as the
+// PRISM file parser, so that the MDPs built are the
+// same as the ones read from files with the same
+// content. Actions are numbered in the order in which
+// they are used first.
+//=====================================================
+
+/**
+ * @brief Starts building an MDP
+ * @param labelComponents The names of the label components of the states
+ */
+MDPBuilder::MDPBuilder(const std::vector<std::string> &labelComponents) {
+    mdp.labelComponents = labelComponents;
+    mdp.labels.setNofComponents(labelComponents.size());
+    mdp.initialState = 0;
+}
+
+/**
+ * @brief Adds the next state
+ * @param label The values of the label components of the state
+ * @return The number of the state
+ */
+unsigned int MDPBuilder::addState(const std::vector<std::string> &label) {
+    if (label.size()!=mdp.labelComponents.size()) {
+        std::ostringstream error;
+        error << "Error: State " << mdp.nofStates() << " has " << label.size() << " label components, but " << mdp.labelComponents.size() << " were declared.";
+        throw error.str();
+    }
+    mdp.labels.addState(label);
+    mdp.transitions.addState();
+    return mdp.nofStates()-1;
+}
+
+/**
+ * @brief Adds a transition to the last state added
+ * @param action The name of the action of the transition, or "" for a transition without an action
+ */
+void MDPBuilder::addChoice(const std::string &action) {
+    if (mdp.nofStates()==0) throw "Error: A transition has been added before the first state.";
+    int actionNumber = -1;
+    if (action!="") {
+        auto it = actionNumbers.find(action);
+        if (it==actionNumbers.end()) {
+            it = actionNumbers.insert(std::make_pair(action,(int)mdp.actions.size())).first;
+            mdp.actions.push_back(action);
+        }
+        actionNumber = it->second;
+    }
+    mdp.transitions.addChoice(actionNumber);
+}
+
+/**
+ * @brief Adds an edge to the last transition added
+ * @param target The target state, which may also be added later
+ * @param probability The probability of the edge
+ */
+void MDPBuilder::addEdge(unsigned int target, double probability) {
+    if ((mdp.nofStates()==0) || (mdp.transitions.nofChoices(mdp.nofStates()-1)==0)) throw "Error: An edge has been added before the first transition of its state.";
+    if (!(probability>=0.0)) throw "Error: An edge has a negative probability.";
+    mdp.transitions.addEdge(probability,target);
+}
+
+/**
+ * @brief Checks the MDP and hands it over
+ * @return The MDP
+ */
+MDP MDPBuilder::build() {
+    if (mdp.nofStates()==0) throw "Error: The MDP has no states.";
+    if (mdp.initialState>=mdp.nofStates()) throw "Error: The initial state of the MDP is not one of its states.";
+    for (unsigned int target : mdp.transitions.targets) {
+        if (target>=mdp.nofStates()) {
+            std::ostringstream error;
+            error << "Error: A transition leads to state " << target << ", but the MDP only has " << mdp.nofStates() << " states.";
+            throw error.str();
+        }
+    }
+    mdp.labels.finishAddingStates();
+    actionNumbers.clear();
+    mdp.checkTransitions();
+    return std::move(mdp);
+}
@@ -0,0 +1,40 @@
+#include "memoryMappedFile.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Maps a file into memory
+ * @param filename The name of the file
+ */
+MemoryMappedFile::MemoryMappedFile(const std::string &filename) : data(NULL), length(0), failed(false) {
+    int fd = open(filename.c_str(),O_RDONLY);
+    if (fd==-1) {
+        failed = true;
+        return;
+    }
+    struct stat fileInfo;
+    if (fstat(fd,&fileInfo)!=0) {
+        close(fd);
+        failed = true;
+        return;
+    }
+    length = fileInfo.st_size;
+    if (length>0) {
+        void *mapped = mmap(NULL,length,PROT_READ,MAP_PRIVATE,fd,0);
+        if (mapped==MAP_FAILED) {
+            failed = true;
+            length = 0;
+        } else {
+            data = static_cast<const char*>(mapped);
+            // The files are typically read from the front to the back
+            madvise(mapped,length,MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (data!=NULL) munmap(const_cast<char*>(data),length);
+}
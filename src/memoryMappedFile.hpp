@@ -0,0 +1,30 @@
+#ifndef __MEMORY_MAPPED_FILE_HPP____
+#define __MEMORY_MAPPED_FILE_HPP____
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief A read-only file that is mapped into memory. If the file cannot be opened, "fail()" returns true.
+ *        Empty files are supported and have begin()==end().
+ */
+class MemoryMappedFile {
+private:
+    const char *data;
+    size_t length;
+    bool failed;
+
+    // Not copyable
+    MemoryMappedFile(const MemoryMappedFile &other) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile &other) = delete;
+
+public:
+    MemoryMappedFile(const std::string &filename);
+    ~MemoryMappedFile();
+    bool fail() const { return failed; }
+    const char *begin() const { return data; }
+    const char *end() const { return data+length; }
+    size_t size() const { return length; }
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "mdp.hpp"
+#include <iostream>
+#include <sstream>
+#include <exception>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//=====================================================
+// Search for the best RA level
+//
+// The search strategy consists of parts that are run
+// one after the other on the same interval of RA
+// levels [minQuality,maxQuality]. Every part probes
+// RA levels with ParityMDP::computeRAPolicy until the
+// interval is small enough. The best policy found by
+// any part is the result.
+//=====================================================
+
+/**
+ * @brief Parses a search strategy such as "i:0.1:0.05,b:0.01:0.01", consisting of comma-separated parts of the
+ *        form "<kind>:<precision>:<value iteration threshold>"
+ * @param searchStrategy The search strategy
+ * @return The parts of the search strategy
+ */
+std::vector<SearchStrategyPart> parseSearchStrategy(const std::string &searchStrategy) {
+    std::vector<SearchStrategyPart> searchStrategyParts;
+    std::stringstream ssA(searchStrategy);
+    std::string thisPart;
+    while (std::getline(ssA,thisPart,',')) {
+        std::stringstream ssB(thisPart);
+        std::string partA = "";
+        std::getline(ssB,partA,':');
+        if (partA=="b") {
+            // Binary search
+            double a;
+            ssB >> a;
+            char sep;
+            ssB >> sep;
+            if ((ssB.fail()) or (sep!=':')) throw "Illegal binary search string (1).";
+            double b;
+            ssB >> b;
+            if (ssB.bad()) throw "Illegal binary search string (2).";
+            searchStrategyParts.push_back(SearchStrategyPart('b',a,b));
+        } else if (partA=="i") {
+            // Incremental
+            double a;
+            ssB >> a;
+            char sep;
+            ssB >> sep;
+            if ((ssB.fail()) or (sep!=':')) throw "Illegal incremental search string (1).";
+            double b;
+            ssB >> b;
+            if (ssB.bad()) throw "Illegal incremental search string (2).";
+            searchStrategyParts.push_back(SearchStrategyPart('i',a,b));
+        } else if (partA=="k") {
+            // k-ary search
+            double a;
+            ssB >> a;
+            char sep;
+            ssB >> sep;
+            if ((ssB.fail()) or (sep!=':')) throw "Illegal k-ary search string (1).";
+            double b;
+            ssB >> b;
+            if (ssB.bad()) throw "Illegal k-ary search string (2).";
+            searchStrategyParts.push_back(SearchStrategyPart('k',a,b));
+        } else {
+            std::ostringstream error;
+            error << "All strategy parts need to be 'b'inary search, 'k'-ary search, or 'i'ncremental: '" << partA << "'";
+            throw error.str();
+        }
+    }
+    return searchStrategyParts;
+}
+
+/**
+ * @brief Searches for the RA policy with the highest RA level
+ * @param settings The search strategy and value iteration settings
+ * @param cache A cache for value iteration results that is shared by all probes, or NULL
+ * @param statistics If not NULL, the statistics of every probe are appended to it
+ * @param log If not NULL, the results of the probes are reported to it
+ * @return The best policy found and its quality. If no probe has succeeded, the policy is empty and the quality is 0.
+ */
+std::pair<Strategy,double> ParityMDP::searchRAPolicy(const PolicySearchSettings &settings, ValueIterationCache *cache, PerformanceStatistics *statistics, std::ostream *log) const {
+    ValueIterationSettings valueIterationSettings = settings.valueIterationSettings;
+    const unsigned int nofParallelProbes = settings.nofParallelProbes;
+    double minQuality = settings.minQuality;
+    double maxQuality = settings.maxQuality;
+    std::pair<Strategy,double> bestStrategy;
+    bestStrategy.second = 0.0;
+    ProbeStatistics probeStatistics;
+    auto recordProbe = [statistics](ProbeStatistics &probe) {
+        if (statistics!=NULL) statistics->probes.push_back(std::move(probe));
+        probe = ProbeStatistics();
+    };
+
+    for (const SearchStrategyPart &currentSearchStrategyTuple : settings.searchStrategy) {
+
+        valueIterationSettings.epsilon = std::get<2>(currentSearchStrategyTuple);
+
+        switch (std::get<0>(currentSearchStrategyTuple)) {
+        case 'i':
+        {
+            double mid = minQuality + std::get<1>(currentSearchStrategyTuple);
+            while (mid <= 1.0) {
+                auto thisStrategy = computeRAPolicy(mid,valueIterationSettings,cache,statistics?&probeStatistics:NULL,log);
+                recordProbe(probeStatistics);
+                if (log!=NULL) *log << "Quality computed: " << thisStrategy.second << std::endl;
+                if (thisStrategy.second>=mid) {
+                    minQuality = thisStrategy.second;
+                    mid = thisStrategy.second + std::get<1>(currentSearchStrategyTuple);
+                    bestStrategy = std::move(thisStrategy);
+                } else {
+                    // Abort. Use "min" as signalizer
+                    mid = 2.0;
+                }
+            }
+        }
+            break;
+        case 'b':
+        {
+            while ((maxQuality-minQuality) > std::get<1>(currentSearchStrategyTuple)) {
+                double mid = (maxQuality+minQuality)/2;
+                auto thisStrategy = computeRAPolicy(mid,valueIterationSettings,cache,statistics?&probeStatistics:NULL,log);
+                recordProbe(probeStatistics);
+                if (log!=NULL) *log << "Quality computed: " << thisStrategy.second << ", asking for " << mid << std::endl;
+                if (thisStrategy.second>=mid) {
+                    // foundStrategy
+                    minQuality = thisStrategy.second;
+                    bestStrategy = std::move(thisStrategy);
+                } else {
+                    maxQuality = mid;
+                }
+            }
+        }
+            break;
+        case 'k':
+        {
+            // Like binary search, but with several RA levels probed in parallel. Each probe
+            // gets its share of the threads for its own value iteration calls.
+            if (nofParallelProbes==0) throw "Error: The number of parallel probes must be positive.";
+#ifdef _OPENMP
+            const int nofThreadsPerProbe = std::max(1,omp_get_max_threads()/(int)nofParallelProbes);
+            omp_set_max_active_levels(std::max(omp_get_max_active_levels(),omp_get_active_level()+2));
+#endif
+            while ((maxQuality-minQuality) > std::get<1>(currentSearchStrategyTuple)) {
+                std::vector<double> mids(nofParallelProbes);
+                for (unsigned int j=0;j<nofParallelProbes;j++) {
+                    mids[j] = minQuality+(maxQuality-minQuality)*(j+1)/(nofParallelProbes+1);
+                }
+                std::vector<std::pair<Strategy,double> > strategies(nofParallelProbes);
+                std::vector<ProbeStatistics> probes(nofParallelProbes);
+                std::vector<std::ostringstream> probeLogs(nofParallelProbes);
+                std::exception_ptr errorInProbe;
+                #pragma omp parallel for schedule(dynamic,1) num_threads(nofParallelProbes)
+                for (unsigned int j=0;j<nofParallelProbes;j++) {
+#ifdef _OPENMP
+                    omp_set_num_threads(nofThreadsPerProbe);
+#endif
+                    // Exceptions must not leave the parallel region, so they are rethrown after it. The log of
+                    // every probe is buffered, so that the logs of the probes are not interleaved.
+                    try {
+                        strategies[j] = computeRAPolicy(mids[j],valueIterationSettings,cache,statistics?&(probes[j]):NULL,(log!=NULL)?&(probeLogs[j]):NULL);
+                    } catch (...) {
+                        #pragma omp critical
+                        errorInProbe = std::current_exception();
+                    }
+                }
+                if (log!=NULL) {
+                    for (auto &probeLog : probeLogs) *log << probeLog.str();
+                }
+                if (errorInProbe) std::rethrow_exception(errorInProbe);
+                for (auto &probe : probes) recordProbe(probe);
+
+                // Narrow the search interval to the best success and the lowest failure above it
+                unsigned int bestProbe = nofParallelProbes;
+                for (unsigned int j=0;j<nofParallelProbes;j++) {
+                    if (log!=NULL) *log << "Quality computed: " << strategies[j].second << ", asking for " << mids[j] << std::endl;
+                    if ((strategies[j].second>=mids[j]) && (strategies[j].second>minQuality)) {
+                        minQuality = strategies[j].second;
+                        bestProbe = j;
+                    }
+                }
+                if (bestProbe<nofParallelProbes) bestStrategy = std::move(strategies[bestProbe]);
+                for (unsigned int j=0;j<nofParallelProbes;j++) {
+                    if ((strategies[j].second<mids[j]) && (mids[j]>minQuality)) maxQuality = std::min(maxQuality,mids[j]);
+                }
+            }
+        }
+            break;
+        default:
+            throw "Error: Unknown search strategy part.";
+        }
+    }
+    return bestStrategy;
+}
@@ -0,0 +1,404 @@
+#include "server.hpp"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <exception>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+//=====================================================
+// Server mode
+//
+// The requests are read line by line, either from the
+// standard input stream or from the connections to a
+// Unix domain socket, which are served one after the
+// other. Policy computations use all threads anyway,
+// so serving several connections at the same time
+// would not make them faster.
+//=====================================================
+
+namespace {
+
+/**
+ * @brief A stream buffer that reads from and writes to a file descriptor (e.g., a socket)
+ */
+class FileDescriptorStreamBuffer : public std::streambuf {
+private:
+    int fd;
+    std::vector<char> inputBuffer;
+    std::vector<char> outputBuffer;
+protected:
+    int underflow() {
+        if (gptr()<egptr()) return traits_type::to_int_type(*gptr());
+        ssize_t nofBytesRead;
+        do {
+            nofBytesRead = read(fd,inputBuffer.data(),inputBuffer.size());
+        } while ((nofBytesRead<0) && (errno==EINTR));
+        if (nofBytesRead<=0) return traits_type::eof();
+        setg(inputBuffer.data(),inputBuffer.data(),inputBuffer.data()+nofBytesRead);
+        return traits_type::to_int_type(*gptr());
+    }
+    int overflow(int c) {
+        if (sync()!=0) return traits_type::eof();
+        if (c!=traits_type::eof()) {
+            *pptr() = c;
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync() {
+        const char *pos = pbase();
+        while (pos<pptr()) {
+            // MSG_NOSIGNAL: A client that has disconnected must not terminate the server by SIGPIPE
+            const ssize_t nofBytesWritten = send(fd,pos,pptr()-pos,MSG_NOSIGNAL);
+            if (nofBytesWritten<0) {
+                if (errno==EINTR) continue;
+                return -1;
+            }
+            pos += nofBytesWritten;
+        }
+        setp(outputBuffer.data(),outputBuffer.data()+outputBuffer.size());
+        return 0;
+    }
+public:
+    FileDescriptorStreamBuffer(int _fd) : fd(_fd), inputBuffer(1 << 16), outputBuffer(1 << 20) {
+        setg(inputBuffer.data(),inputBuffer.data(),inputBuffer.data());
+        setp(outputBuffer.data(),outputBuffer.data()+outputBuffer.size());
+    }
+};
+
+/**
+ * @brief Reads a whole file into a string
+ */
+std::string readFile(const std::string &filename) {
+    std::ifstream inFile(filename);
+    if (inFile.fail()) {
+        std::ostringstream error;
+        error << "Cannot open parity automaton file '" << filename << "'.";
+        throw error.str();
+    }
+    std::ostringstream contents;
+    contents << inFile.rdbuf();
+    return contents.str();
+}
+
+/**
+ * @brief Parses a floating point number from a request
+ */
+double parseDouble(const std::string &text, const std::string &param) {
+    std::istringstream is(text);
+    double value;
+    is >> value;
+    if (is.fail()) {
+        std::ostringstream error;
+        error << "Illegal floating point number after '" << param << "'.";
+        throw error.str();
+    }
+    return value;
+}
+
+}
+
+/**
+ * @brief Reads an MDP from its files
+ * @param modelName The file name prefix of the MDP
+ */
+std::unique_ptr<MDP> SolverServer::readModel(const std::string &modelName) const {
+    std::unique_ptr<MDP> mdp;
+    try {
+        mdp.reset(new MDP(modelName,settings.inputFormat));
+    } catch (int) {
+        // The files could not be opened
+        std::ostringstream error;
+        error << "Cannot read the MDP '" << modelName << "'.";
+        throw error.str();
+    }
+    std::cerr << "Loaded MDP " << modelName << " with " << mdp->nofStates() << " states.\n";
+    return mdp;
+}
+
+/**
+ * @brief Returns an MDP, reading it if it has not been read before
+ * @param modelName The file name prefix of the MDP
+ */
+const MDP &SolverServer::getModel(const std::string &modelName) {
+    auto it = models.find(modelName);
+    if (it==models.end()) it = models.insert(std::make_pair(modelName,readModel(modelName))).first;
+    return *(it->second);
+}
+
+/**
+ * @brief Reads an MDP again after its files have changed, e.g., after a few transitions have been changed. The
+ *        cached products with the MDP are rebuilt for the new version. Their value iteration caches start with the
+ *        results for the previous version, so that value iteration only needs to update the product states that
+ *        can reach a state that has changed. States of the two versions of the MDP are identified by their numbers.
+ *        If the new version cannot be read, or a product cannot be built for it, the previous version is kept.
+ * @param modelName The file name prefix of the MDP
+ */
+void SolverServer::updateModel(const std::string &modelName) {
+    auto model = models.find(modelName);
+    if (model==models.end()) {
+        getModel(modelName);
+        return;
+    }
+    std::unique_ptr<MDP> mdp = readModel(modelName);
+    const std::vector<unsigned int> previousMDPStates = mdp->findPreviousStates(*(model->second));
+
+    // All products are built before any is replaced, as the previous ones refer to the labels of the previous MDP
+    std::vector<std::list<Product>::iterator> previousProducts;
+    std::vector<Product> updatedProducts;
+    for (auto it = products.begin();it!=products.end();it++) {
+        if (it->modelName!=modelName) continue;
+        ParityAutomaton automaton;
+        std::istringstream automatonStream(it->parityAutomatonText);
+        automaton.read(automatonStream);
+
+        Product product;
+        product.modelName = modelName;
+        product.parityAutomatonText = it->parityAutomatonText;
+        std::vector<unsigned int> previousBaseStates;
+        if (settings.bisimulation) {
+            std::vector<bool> relevantComponents;
+            std::vector<bool> relevantActions;
+            ParityMDP::findReferencedLabels(automaton,*mdp,relevantComponents,relevantActions);
+            product.quotientMDP.reset(new MDP(*mdp,relevantComponents,relevantActions,product.quotientMapping));
+            previousBaseStates = findPreviousQuotientStates(product.quotientMapping,it->quotientMapping,previousMDPStates);
+        } else {
+            previousBaseStates = previousMDPStates;
+        }
+        product.parityMDP.reset(new ParityMDP(automaton,settings.bisimulation?*product.quotientMDP:*mdp));
+        if (settings.valueIterationCacheSize>0) {
+            product.cache.reset(new ValueIterationCache(settings.valueIterationCacheSize));
+            if (it->cache) {
+                const std::vector<unsigned int> previousStates = product.parityMDP->findPreviousStates(*(it->parityMDP),previousBaseStates);
+                product.cache->setPreviousVersion(*(it->cache),previousStates);
+                std::cerr << "Updated product with " << std::count(previousStates.begin(),previousStates.end(),(unsigned int)-1) << " of " << previousStates.size() << " states changed.\n";
+            }
+        }
+        previousProducts.push_back(it);
+        updatedProducts.push_back(std::move(product));
+    }
+
+    for (unsigned int i=0;i<previousProducts.size();i++) *(previousProducts[i]) = std::move(updatedProducts[i]);
+    model->second = std::move(mdp);
+}
+
+/**
+ * @brief Returns the product of an MDP and a parity automaton, building it if it is not in the cache
+ * @param modelName The file name prefix of the MDP
+ * @param parityAutomatonText The parity automaton in the format of the parity automaton files
+ */
+SolverServer::Product &SolverServer::getProduct(const std::string &modelName, const std::string &parityAutomatonText) {
+    for (auto it = products.begin();it!=products.end();it++) {
+        if ((it->modelName==modelName) && (it->parityAutomatonText==parityAutomatonText)) {
+            products.splice(products.begin(),products,it);
+            return products.front();
+        }
+    }
+
+    const MDP &mdp = getModel(modelName);
+    ParityAutomaton automaton;
+    std::istringstream automatonStream(parityAutomatonText);
+    automaton.read(automatonStream);
+
+    std::list<Product> newProducts(1);
+    Product &product = newProducts.front();
+    product.modelName = modelName;
+    product.parityAutomatonText = parityAutomatonText;
+    if (settings.bisimulation) {
+        std::vector<bool> relevantComponents;
+        std::vector<bool> relevantActions;
+        ParityMDP::findReferencedLabels(automaton,mdp,relevantComponents,relevantActions);
+        product.quotientMDP.reset(new MDP(mdp,relevantComponents,relevantActions,product.quotientMapping));
+    }
+    product.parityMDP.reset(new ParityMDP(automaton,settings.bisimulation?*product.quotientMDP:mdp));
+    if (settings.valueIterationCacheSize>0) product.cache.reset(new ValueIterationCache(settings.valueIterationCacheSize));
+
+    // Only add the product once it has been built completely
+    products.splice(products.begin(),newProducts);
+    while (products.size()>std::max(1u,settings.maxNofCachedProducts)) products.pop_back();
+    return products.front();
+}
+
+/**
+ * @brief Answers a "solve" request
+ * @param request The words of the request line
+ * @param output The stream for the response
+ */
+void SolverServer::solve(const std::vector<std::string> &request, std::ostream &output) {
+    if (request.size()<3) throw "A 'solve' request needs a model and a parity automaton file.";
+    const std::string &modelName = request[1];
+    const std::string &parityFilename = request[2];
+    PolicySearchSettings searchSettings = settings.policySearchSettings;
+    std::string outputFilename = "";
+    std::string binaryStrategyFilename = "";
+    for (unsigned int i=3;i<request.size();i++) {
+        const std::string &param = request[i];
+        if (i+1>=request.size()) {
+            std::ostringstream error;
+            error << "No parameter after '" << param << "'.";
+            throw error.str();
+        }
+        if (param=="--ses") {
+            searchSettings.searchStrategy = parseSearchStrategy(request[++i]);
+        } else if (param=="--min") {
+            searchSettings.minQuality = parseDouble(request[++i],param);
+        } else if (param=="--max") {
+            searchSettings.maxQuality = parseDouble(request[++i],param);
+        } else if (param=="--output") {
+            outputFilename = request[++i];
+        } else if (param=="--binaryStrategy") {
+            binaryStrategyFilename = request[++i];
+        } else {
+            std::ostringstream error;
+            error << "Did not understand parameter " << param;
+            throw error.str();
+        }
+    }
+
+    Product &product = getProduct(modelName,readFile(parityFilename));
+    const std::pair<Strategy,double> bestStrategy = product.parityMDP->searchRAPolicy(searchSettings,product.cache.get(),NULL,&std::cerr);
+
+    // Map the policy to the MDP
+    Strategy mappedStrategy;
+    std::vector<unsigned int> mdpStates;
+    if (settings.bisimulation) {
+        mappedStrategy = product.parityMDP->mapPolicyToOriginalMDP(bestStrategy.first,getModel(modelName),product.quotientMapping,mdpStates);
+    }
+    const Strategy &policy = settings.bisimulation?mappedStrategy:bestStrategy.first;
+    const std::vector<unsigned int> &policyMDPStates = settings.bisimulation?mdpStates:product.parityMDP->mdpStates();
+
+    // Write the policy
+    if (binaryStrategyFilename!="") policy.writeBinaryFile(binaryStrategyFilename,policyMDPStates);
+    if (outputFilename!="") {
+        std::ofstream outFile(outputFilename);
+        if (outFile.fail()) {
+            std::ostringstream error;
+            error << "Cannot open strategy file '" << outputFilename << "' for writing.";
+            throw error.str();
+        }
+        policy.writeText(outFile,policyMDPStates);
+        outFile.close();
+        if (outFile.fail()) {
+            std::ostringstream error;
+            error << "Error writing strategy file '" << outputFilename << "'.";
+            throw error.str();
+        }
+    }
+    output << "ok " << bestStrategy.second << "\n";
+    if ((binaryStrategyFilename=="") && (outputFilename=="")) policy.writeText(output,policyMDPStates);
+}
+
+/**
+ * @brief Answers the requests from an input stream until it ends or a "quit" or "shutdown" request is found
+ * @param input The stream of requests
+ * @param output The stream for the responses
+ * @return false if the server has been asked to shut down
+ */
+bool SolverServer::serve(std::istream &input, std::ostream &output) {
+    std::string line;
+    while (std::getline(input,line)) {
+        std::vector<std::string> request;
+        {
+            std::istringstream is(line);
+            std::string word;
+            while (is >> word) request.push_back(word);
+        }
+        if (request.empty()) continue;
+        if ((request[0]=="quit") || (request[0]=="shutdown")) {
+            output << "ok\nend" << std::endl;
+            return request[0]=="quit";
+        }
+
+        // Errors only end the request, not the server
+        std::string error = "";
+        try {
+            if (request[0]=="solve") {
+                solve(request,output);
+            } else if (request[0]=="load") {
+                if (request.size()!=2) throw "A 'load' request needs exactly one model.";
+                loadModel(request[1]);
+                output << "ok\n";
+            } else if (request[0]=="update") {
+                if (request.size()!=2) throw "An 'update' request needs exactly one model.";
+                updateModel(request[1]);
+                output << "ok\n";
+            } else {
+                throw "Unknown request '"+request[0]+"'.";
+            }
+        } catch (int code) {
+            std::ostringstream message;
+            message << "Numerical error " << code;
+            error = message.str();
+        } catch (const char *message) {
+            error = message;
+        } catch (const std::string message) {
+            error = message;
+        } catch (const std::bad_alloc &) {
+            error = "Out of memory.";
+        } catch (const std::exception &exception) {
+            error = exception.what();
+        } catch (...) {
+            error = "Unknown error.";
+        }
+        if (error!="") {
+            if (error.compare(0,7,"Error: ")==0) error = error.substr(7);
+            std::replace(error.begin(),error.end(),'\n',' ');
+            output << "error " << error << "\n";
+        }
+        output << "end" << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Listens on a Unix domain socket and answers the requests of the connections to it one after the other,
+ *        until a "shutdown" request is found
+ * @param socketPath The file name of the socket. An existing socket file of that name is replaced.
+ */
+void SolverServer::serveUnixSocket(const std::string &socketPath) {
+    struct sockaddr_un address;
+    memset(&address,0,sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size()>=sizeof(address.sun_path)) throw "Error: The socket path is too long.";
+    strcpy(address.sun_path,socketPath.c_str());
+
+    struct stat fileStatus;
+    if ((stat(socketPath.c_str(),&fileStatus)==0) && S_ISSOCK(fileStatus.st_mode)) unlink(socketPath.c_str());
+
+    const int listeningSocket = socket(AF_UNIX,SOCK_STREAM,0);
+    if (listeningSocket<0) throw "Error: Cannot create a socket.";
+    if ((bind(listeningSocket,(struct sockaddr*)&address,sizeof(address))!=0) || (listen(listeningSocket,16)!=0)) {
+        close(listeningSocket);
+        std::ostringstream error;
+        error << "Cannot listen on socket '" << socketPath << "': " << strerror(errno);
+        throw error.str();
+    }
+    std::cerr << "Listening on socket " << socketPath << std::endl;
+
+    bool running = true;
+    while (running) {
+        const int connection = accept(listeningSocket,NULL,NULL);
+        if (connection<0) {
+            if (errno==EINTR) continue;
+            close(listeningSocket);
+            throw "Error: Cannot accept connections on the socket.";
+        }
+        {
+            FileDescriptorStreamBuffer buffer(connection);
+            std::istream input(&buffer);
+            std::ostream output(&buffer);
+            running = serve(input,output);
+            output.flush();
+        }
+        close(connection);
+    }
+    close(listeningSocket);
+    unlink(socketPath.c_str());
+}
@@ -0,0 +1,58 @@
+#ifndef __SERVER_HPP____
+#define __SERVER_HPP____
+
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <iostream>
+#include "mdp.hpp"
+
+/**
+ * @brief Answers a stream of requests for RA policies. The MDPs are read only once, and the products with the parity
+ *        automata are kept (with their value iteration caches) for later requests with the same MDP and the same
+ *        parity automaton, so that only the policy search has to be performed again. The products are dropped in
+ *        least-recently-used order when there are more than "maxNofCachedProducts" of them.
+ *
+ *        Every request is one line. The request "solve <model> <parityFile> [--ses <searchStrategy>] [--min <x>]
+ *        [--max <x>] [--output <file>] [--binaryStrategy <file>]" computes a policy, "load <model>" reads an MDP in
+ *        advance, "update <model>" reads it again after its files have changed (see "updateModel"), "quit" ends
+ *        the session, and "shutdown" also stops the server. Every response starts with a line
+ *        "ok" (for "solve": "ok <quality>") or "error <message>". For "solve" without an output file, the policy
+ *        follows in the text format. Every response ends with a line "end".
+ */
+class SolverServer {
+public:
+    struct Settings {
+        PolicySearchSettings policySearchSettings; // The search strategy and bounds are the defaults for the requests
+        bool bisimulation;
+        MDP::InputFormat inputFormat;
+        unsigned int valueIterationCacheSize; // in MB, per product
+        unsigned int maxNofCachedProducts;
+        Settings() : bisimulation(false), inputFormat(MDP::PRISM_FILES), valueIterationCacheSize(1024), maxNofCachedProducts(8) {}
+    };
+private:
+    struct Product {
+        std::string modelName;
+        std::string parityAutomatonText;
+        std::unique_ptr<MDP> quotientMDP;
+        BisimulationQuotientMapping quotientMapping;
+        std::unique_ptr<ParityMDP> parityMDP;
+        std::unique_ptr<ValueIterationCache> cache;
+    };
+    Settings settings;
+    std::map<std::string,std::unique_ptr<MDP> > models; // The MDPs must not move, as the products refer to their labels
+    std::list<Product> products; // Most recently used product first
+    std::unique_ptr<MDP> readModel(const std::string &modelName) const;
+    const MDP &getModel(const std::string &modelName);
+    Product &getProduct(const std::string &modelName, const std::string &parityAutomatonText);
+    void solve(const std::vector<std::string> &request, std::ostream &output);
+public:
+    SolverServer(const Settings &_settings) : settings(_settings) {}
+    void loadModel(const std::string &modelName) { getModel(modelName); }
+    void updateModel(const std::string &modelName);
+    bool serve(std::istream &input, std::ostream &output);
+    void serveUnixSocket(const std::string &socketPath);
+};
+
+#endif
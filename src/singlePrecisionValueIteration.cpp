@@ -0,0 +1,194 @@
+#include "singlePrecisionValueIteration.hpp"
+#include <cmath>
+#include <cfloat>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SINGLE_PRECISION_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+//=====================================================
+// Single precision value iteration
+//
+// The dot products of the choices are computed by one
+// of several kernels, which is selected at runtime
+// depending on the instruction sets supported by the
+// processor. All kernels compute the best choice of
+// one state. The vectorized kernels gather the values
+// of up to 8 (AVX2) or 16 (AVX-512) successor states
+// at once and process the last edges of a choice with
+// masked instructions.
+//=====================================================
+
+namespace {
+
+typedef float (*BestChoiceFunction)(const SinglePrecisionTransitions &transitions, unsigned int index, const float *values, unsigned int &bestChoice);
+
+float bestChoiceScalar(const SinglePrecisionTransitions &transitions, unsigned int index, const float *values, unsigned int &bestChoice) {
+    const unsigned int choiceBegin = transitions.stateOffsets[index];
+    float bestValue = 0.0f;
+    for (unsigned int choice=choiceBegin;choice<transitions.stateOffsets[index+1];choice++) {
+        float value = 0.0f;
+        for (unsigned int k=transitions.choiceOffsets[choice];k<transitions.choiceOffsets[choice+1];k++) {
+            value += transitions.probabilities[k]*values[transitions.targets[k]];
+        }
+        if (value > bestValue) {
+            bestValue = value;
+            bestChoice = choice-choiceBegin;
+        }
+    }
+    return bestValue;
+}
+
+#ifdef SINGLE_PRECISION_X86_KERNELS
+
+__attribute__((target("avx2,fma"))) float bestChoiceAVX2(const SinglePrecisionTransitions &transitions, unsigned int index, const float *values, unsigned int &bestChoice) {
+    const unsigned int choiceBegin = transitions.stateOffsets[index];
+    const int *targets = reinterpret_cast<const int*>(transitions.targets.data());
+    const float *probabilities = transitions.probabilities.data();
+    const __m256i laneNumbers = _mm256_setr_epi32(0,1,2,3,4,5,6,7);
+    float bestValue = 0.0f;
+    for (unsigned int choice=choiceBegin;choice<transitions.stateOffsets[index+1];choice++) {
+        unsigned int k = transitions.choiceOffsets[choice];
+        const unsigned int edgeEnd = transitions.choiceOffsets[choice+1];
+        __m256 sum = _mm256_setzero_ps();
+        for (;k+8<=edgeEnd;k+=8) {
+            const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(targets+k));
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(probabilities+k),_mm256_i32gather_ps(values,indices,4),sum);
+        }
+        if (k<edgeEnd) {
+            const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(edgeEnd-k),laneNumbers);
+            const __m256i indices = _mm256_maskload_epi32(targets+k,mask);
+            const __m256 successorValues = _mm256_mask_i32gather_ps(_mm256_setzero_ps(),values,indices,_mm256_castsi256_ps(mask),4);
+            sum = _mm256_fmadd_ps(_mm256_maskload_ps(probabilities+k,mask),successorValues,sum);
+        }
+        __m128 halves = _mm_add_ps(_mm256_castps256_ps128(sum),_mm256_extractf128_ps(sum,1));
+        halves = _mm_hadd_ps(halves,halves);
+        halves = _mm_hadd_ps(halves,halves);
+        const float value = _mm_cvtss_f32(halves);
+        if (value > bestValue) {
+            bestValue = value;
+            bestChoice = choice-choiceBegin;
+        }
+    }
+    return bestValue;
+}
+
+__attribute__((target("avx512f"))) float bestChoiceAVX512(const SinglePrecisionTransitions &transitions, unsigned int index, const float *values, unsigned int &bestChoice) {
+    const unsigned int choiceBegin = transitions.stateOffsets[index];
+    const int *targets = reinterpret_cast<const int*>(transitions.targets.data());
+    const float *probabilities = transitions.probabilities.data();
+    float bestValue = 0.0f;
+    for (unsigned int choice=choiceBegin;choice<transitions.stateOffsets[index+1];choice++) {
+        unsigned int k = transitions.choiceOffsets[choice];
+        const unsigned int edgeEnd = transitions.choiceOffsets[choice+1];
+        __m512 sum = _mm512_setzero_ps();
+        for (;k+16<=edgeEnd;k+=16) {
+            const __m512i indices = _mm512_loadu_si512(targets+k);
+            sum = _mm512_fmadd_ps(_mm512_loadu_ps(probabilities+k),_mm512_mask_i32gather_ps(_mm512_setzero_ps(),0xFFFF,indices,values,4),sum);
+        }
+        if (k<edgeEnd) {
+            const __mmask16 mask = (__mmask16)((1u << (edgeEnd-k))-1);
+            const __m512i indices = _mm512_maskz_loadu_epi32(mask,targets+k);
+            const __m512 successorValues = _mm512_mask_i32gather_ps(_mm512_setzero_ps(),mask,indices,values,4);
+            sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask,probabilities+k),successorValues,sum);
+        }
+        const __m256 upperHalf = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(_mm256_setzero_pd(),0xF,_mm512_castps_pd(sum),1));
+        const __m256 lowerHalf = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(_mm256_setzero_pd(),0xF,_mm512_castps_pd(sum),0));
+        const __m256 halves = _mm256_add_ps(lowerHalf,upperHalf);
+        __m128 quarters = _mm_add_ps(_mm256_castps256_ps128(halves),_mm256_extractf128_ps(halves,1));
+        quarters = _mm_hadd_ps(quarters,quarters);
+        quarters = _mm_hadd_ps(quarters,quarters);
+        const float value = _mm_cvtss_f32(quarters);
+        if (value > bestValue) {
+            bestValue = value;
+            bestChoice = choice-choiceBegin;
+        }
+    }
+    return bestValue;
+}
+
+#endif
+
+/**
+ * @brief Selects the fastest kernel that the processor supports.
+ */
+struct SinglePrecisionKernel {
+    BestChoiceFunction function;
+    const char *name;
+    SinglePrecisionKernel() : function(bestChoiceScalar), name("scalar") {
+#ifdef SINGLE_PRECISION_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            function = bestChoiceAVX512;
+            name = "AVX-512";
+        } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            function = bestChoiceAVX2;
+            name = "AVX2";
+        }
+#endif
+    }
+};
+
+const SinglePrecisionKernel &getSinglePrecisionKernel() {
+    static const SinglePrecisionKernel kernel;
+    return kernel;
+}
+
+}
+
+float roundDownToFloat(double value) {
+    float result = static_cast<float>(value);
+    if (result>value) result = std::nextafter(result,0.0f);
+    return result;
+}
+
+bool canUseSinglePrecisionValueIteration(const SinglePrecisionTransitions &transitions) {
+    // The relative error of a dot product with n edges is below n*FLT_EPSILON/2, so for choices with
+    // about 1000 edges, the lower bounds would be noticeably worse than what double precision can reach.
+    return transitions.maxNofEdgesPerChoice<1000;
+}
+
+unsigned int performSinglePrecisionValueIteration(const SinglePrecisionTransitions &transitions, std::vector<float> &values, std::vector<unsigned int> &policy, double epsilon) {
+    const BestChoiceFunction bestChoiceValue = getSinglePrecisionKernel().function;
+    const unsigned int nofUpdatedStates = transitions.states.size();
+
+    // Scaling the new values down by this factor compensates the rounding errors of the dot products
+    // (and of the scaling itself), so that the values remain lower bounds.
+    const float scale = 1.0f-(transitions.maxNofEdgesPerChoice+2)*FLT_EPSILON;
+
+    // The values are updated in place
+    const unsigned int nofBlocks = transitions.blockOffsets.size()-1;
+    float *currentValues = values.data();
+
+    std::vector<float> blockMaxChanges(nofBlocks);
+    unsigned int nofSweeps = 0;
+    bool terminated = nofUpdatedStates==0;
+    while (!terminated) {
+        nofSweeps++;
+
+        #pragma omp parallel for schedule(dynamic)
+        for (unsigned int b=0;b<nofBlocks;b++) {
+            float blockMaxChange = 0.0f;
+            for (unsigned int i=transitions.blockOffsets[b];i<transitions.blockOffsets[b+1];i++) {
+                const unsigned int state = transitions.states[i];
+                unsigned int bestChoice = 0;
+                const float newValue = bestChoiceValue(transitions,i,currentValues,bestChoice)*scale;
+                if (newValue > currentValues[state]) {
+                    blockMaxChange = std::max(blockMaxChange,newValue-currentValues[state]);
+                    currentValues[state] = newValue;
+                    policy[state] = bestChoice;
+                }
+            }
+            blockMaxChanges[b] = blockMaxChange;
+        }
+
+        const float maxChange = *std::max_element(blockMaxChanges.begin(),blockMaxChanges.end());
+        terminated = (double)maxChange*nofUpdatedStates<=epsilon;
+    }
+    return nofSweeps;
+}
+
+const char *getSinglePrecisionKernelName() {
+    return getSinglePrecisionKernel().name;
+}
@@ -0,0 +1,101 @@
+#ifndef __SINGLE_PRECISION_VALUE_ITERATION_HPP____
+#define __SINGLE_PRECISION_VALUE_ITERATION_HPP____
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief A compact copy of the transitions of the states that are updated by value iteration, in which the
+ *        probabilities are stored as floats. The choices of states[i] are stateOffsets[i] to stateOffsets[i+1]-1,
+ *        and the edges of choice j are choiceOffsets[j] to choiceOffsets[j+1]-1. The probabilities are rounded
+ *        down, so that the values computed from them are lower bounds of the exact values.
+ *
+ *        As in block Gauss-Seidel value iteration, the states are split into blocks of fixed size, which are the
+ *        units of work of the threads. The targets of the edges are state numbers. The states of block b are
+ *        states[blockOffsets[b]] to states[blockOffsets[b+1]-1].
+ */
+struct SinglePrecisionTransitions {
+    static const unsigned int blockSize = 16384;
+    unsigned int nofStates; // Of the MDP
+    std::vector<unsigned int> states;
+    std::vector<unsigned int> blockOffsets;
+    std::vector<unsigned int> stateOffsets;
+    std::vector<unsigned int> choiceOffsets;
+    std::vector<uint32_t> targets;
+    std::vector<float> probabilities;
+    unsigned int maxNofEdgesPerChoice;
+    SinglePrecisionTransitions() : nofStates(0), maxNofEdgesPerChoice(0) {}
+};
+
+/**
+ * @brief Rounds a double towards zero to the next float
+ * @param value The (non-negative) value
+ * @return The largest float that is not larger than the value
+ */
+float roundDownToFloat(double value);
+
+/**
+ * @brief Builds the single precision copy of the transitions of the states that value iteration updates.
+ * @param transitions The transition relation - any class that offers the interface of a "TransitionMatrix"
+ * @param touchable Which states are updated
+ * @return The compact transitions
+ */
+template<class Transitions> SinglePrecisionTransitions buildSinglePrecisionTransitions(const Transitions &transitions, const std::vector<bool> &touchable) {
+    const unsigned int blockSize = SinglePrecisionTransitions::blockSize;
+    SinglePrecisionTransitions result;
+    result.nofStates = transitions.nofStates();
+    result.stateOffsets.push_back(0);
+    result.choiceOffsets.push_back(0);
+    for (unsigned int i=0;i<transitions.nofStates();i++) {
+        if (i%blockSize==0) result.blockOffsets.push_back(result.states.size());
+        if (!touchable[i]) continue;
+        result.states.push_back(i);
+        for (unsigned int j=0;j<transitions.nofChoices(i);j++) {
+            const unsigned int choice = transitions.choiceBegin(i)+j;
+            for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+                const unsigned int target = transitions.target(i,k);
+                result.targets.push_back(target);
+                result.probabilities.push_back(roundDownToFloat(transitions.probability(k)));
+            }
+            result.maxNofEdgesPerChoice = std::max<unsigned int>(result.maxNofEdgesPerChoice,transitions.edgeEnd(choice)-transitions.edgeBegin(choice));
+            result.choiceOffsets.push_back(result.targets.size());
+        }
+        result.stateOffsets.push_back(result.choiceOffsets.size()-1);
+    }
+    result.blockOffsets.push_back(result.states.size());
+    return result;
+}
+
+/**
+ * @brief Checks if the single precision kernel can compute useful lower bounds for the transitions. This is not
+ *        the case if choices have so many edges that the rounding errors are too large.
+ * @param transitions The compact transitions
+ * @return true if the single precision kernel can be used
+ */
+bool canUseSinglePrecisionValueIteration(const SinglePrecisionTransitions &transitions);
+
+/**
+ * @brief Performs value iteration with single precision values. The result is meant as the starting point for
+ *        value iteration with double precision, which then only needs few more steps. All values stay lower bounds
+ *        of the exact values: the probabilities are rounded down, every new value is scaled down by the maximal
+ *        relative rounding error of the float arithmetic, and values never decrease. The latter also makes sure
+ *        that the iteration terminates.
+ *
+ *        The values are updated in place, so values of other blocks may stem from the current or the previous sweep.
+ *        Both are lower bounds, so this does not affect correctness. The dot products of the choices use AVX-512 or AVX2 gather
+ *        instructions if the processor supports them (detected at runtime), and scalar code otherwise.
+ * @param transitions The compact transitions (see "canUseSinglePrecisionValueIteration" and "buildSinglePrecisionTransitions")
+ * @param values The values of all states - states not in "transitions.states" keep their values. Values must be lower bounds.
+ * @param policy The choice with the highest value for every state (indexed by state number). Only changed when the value increases.
+ * @param epsilon The iteration stops when the largest change of a value, multiplied by the number of updated states, is at most epsilon.
+ * @return The number of sweeps over the states
+ */
+unsigned int performSinglePrecisionValueIteration(const SinglePrecisionTransitions &transitions, std::vector<float> &values, std::vector<unsigned int> &policy, double epsilon);
+
+/**
+ * @brief Returns the name of the dot product kernel selected for this processor ("AVX-512", "AVX2", or "scalar").
+ */
+const char *getSinglePrecisionKernelName();
+
+#endif
@@ -0,0 +1,130 @@
+#include "statistics.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <ctime>
+#include <sys/resource.h>
+
+namespace {
+
+double getWallSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double getCPUSeconds() {
+    struct timespec time;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&time)!=0) return 0.0;
+    return time.tv_sec+time.tv_nsec*1e-9;
+}
+
+/**
+ * @brief Writes a string as a JSON string literal
+ */
+void writeJSONString(std::ostream &output, const std::string &text) {
+    output << '"';
+    for (char c : text) {
+        if ((c=='"') || (c=='\\')) {
+            output << '\\' << c;
+        } else if ((unsigned char)c<0x20) {
+            output << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        } else {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+void writeTimes(std::ostream &output, double wallSeconds, double cpuSeconds) {
+    output << "\"wallSeconds\": " << wallSeconds << ", \"cpuSeconds\": " << cpuSeconds;
+}
+
+void writeValueIterations(std::ostream &output, const std::vector<ValueIterationStatistics> &valueIterations, const char *indentation) {
+    output << "[";
+    for (unsigned int i=0;i<valueIterations.size();i++) {
+        const ValueIterationStatistics &statistics = valueIterations[i];
+        output << ((i==0)?"\n":",\n") << indentation << "{";
+        writeTimes(output,statistics.wallSeconds,statistics.cpuSeconds);
+        output << ", \"sweeps\": " << statistics.nofSweeps << ", \"singlePrecisionSweeps\": " << statistics.nofSinglePrecisionSweeps
+               << ", \"finalResidual\": " << statistics.finalResidual << ", \"touchableStates\": " << statistics.nofTouchableStates
+               << ", \"peakMemoryKB\": " << statistics.peakMemoryInKB << "}";
+    }
+    output << "]";
+}
+
+}
+
+StopWatch::StopWatch() : wallStart(getWallSeconds()), cpuStart(getCPUSeconds()) {}
+
+double StopWatch::wallSeconds() const {
+    return getWallSeconds()-wallStart;
+}
+
+double StopWatch::cpuSeconds() const {
+    return getCPUSeconds()-cpuStart;
+}
+
+long getPeakMemoryInKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF,&usage)!=0) return -1;
+    return usage.ru_maxrss;
+}
+
+void PerformanceStatistics::addPhase(const std::string &name, const StopWatch &stopWatch) {
+    Phase phase;
+    phase.name = name;
+    phase.wallSeconds = stopWatch.wallSeconds();
+    phase.cpuSeconds = stopWatch.cpuSeconds();
+    phases.push_back(phase);
+}
+
+/**
+ * @brief Writes the statistics as a JSON object
+ * @param filename The name of the file
+ */
+void PerformanceStatistics::writeJSON(const std::string &filename) const {
+    std::ofstream output(filename);
+    if (output.fail()) {
+        std::ostringstream error;
+        error << "Cannot open statistics file '" << filename << "' for writing.";
+        throw error.str();
+    }
+    output << std::setprecision(10);
+    output << "{\n  \"model\": ";
+    writeJSONString(output,model);
+    output << ",\n  \"phases\": [";
+    for (unsigned int i=0;i<phases.size();i++) {
+        output << ((i==0)?"\n":",\n") << "    {\"name\": ";
+        writeJSONString(output,phases[i].name);
+        output << ", ";
+        writeTimes(output,phases[i].wallSeconds,phases[i].cpuSeconds);
+        output << "}";
+    }
+    output << "],\n  \"probes\": [";
+    for (unsigned int i=0;i<probes.size();i++) {
+        const ProbeStatistics &probe = probes[i];
+        output << ((i==0)?"\n":",\n") << "    {\"raLevel\": " << probe.raLevel << ", \"quality\": " << probe.quality << ", ";
+        writeTimes(output,probe.wallSeconds,probe.cpuSeconds);
+        output << ", \"outerIterations\": " << probe.nofOuterIterations << ",\n     \"rounds\": [";
+        for (unsigned int j=0;j<probe.rounds.size();j++) {
+            const FixpointRoundStatistics &round = probe.rounds[j];
+            output << ((j==0)?"\n":",\n") << "       {\"outerIteration\": " << round.outerIteration << ", \"minGoalColor\": " << round.minGoalColor
+                   << ", \"goalStates\": " << round.nofGoalStates << ", \"cacheHit\": " << (round.cacheHit?"true":"false") << ", ";
+            writeTimes(output,round.wallSeconds,round.cpuSeconds);
+            output << ",\n        \"valueIterations\": ";
+            writeValueIterations(output,round.valueIterations,"         ");
+            output << "}";
+        }
+        output << "],\n     \"finalValueIterations\": ";
+        writeValueIterations(output,probe.finalValueIterations,"       ");
+        output << "}";
+    }
+    output << "],\n  \"peakMemoryKB\": " << getPeakMemoryInKB() << "\n}\n";
+
+    output.close();
+    if (output.fail()) {
+        std::ostringstream error;
+        error << "Error writing statistics file '" << filename << "'.";
+        throw error.str();
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef __STATISTICS_HPP____
+#define __STATISTICS_HPP____
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Measures the wall clock time and the CPU time since its construction. The CPU time is the one of the
+ *        whole process (i.e., of all threads), so for computations that run in parallel to each other, it also
+ *        includes the CPU time of the other computations.
+ */
+class StopWatch {
+private:
+    double wallStart;
+    double cpuStart;
+public:
+    StopWatch();
+    double wallSeconds() const;
+    double cpuSeconds() const;
+};
+
+/**
+ * @brief Returns the peak resident memory of the process so far in kilobytes, or -1 if it is not known.
+ */
+long getPeakMemoryInKB();
+
+/**
+ * @brief Statistics of one value iteration call
+ */
+struct ValueIterationStatistics {
+    double wallSeconds;
+    double cpuSeconds;
+    unsigned int nofSweeps; // For the TOPOLOGICAL method: summed up over all SCCs that are on a cycle
+    unsigned int nofSinglePrecisionSweeps; // Of the single precision warm start
+    double finalResidual; // The sum of the value changes in the last sweep (for TOPOLOGICAL: in the last sweeps of all SCCs)
+    unsigned int nofTouchableStates; // The states that are updated by the iteration, i.e., not fixed and not solved qualitatively
+    long peakMemoryInKB;
+    ValueIterationStatistics() : wallSeconds(0.0), cpuSeconds(0.0), nofSweeps(0), nofSinglePrecisionSweeps(0), finalResidual(0.0), nofTouchableStates(0), peakMemoryInKB(-1) {}
+};
+
+/**
+ * @brief Statistics of one round of the inner fixpoint operation in ParityMDP::computeRAPolicy, i.e., of the
+ *        computation of the states from which the current goal states can be reached with the RA level
+ */
+struct FixpointRoundStatistics {
+    unsigned int outerIteration;
+    unsigned int minGoalColor;
+    unsigned int nofGoalStates; // At the start of the round
+    bool cacheHit; // Whether the values have been taken from the value iteration cache
+    double wallSeconds;
+    double cpuSeconds;
+    std::vector<ValueIterationStatistics> valueIterations;
+    FixpointRoundStatistics() : outerIteration(0), minGoalColor(0), nofGoalStates(0), cacheHit(false), wallSeconds(0.0), cpuSeconds(0.0) {}
+};
+
+/**
+ * @brief Statistics of one ParityMDP::computeRAPolicy call
+ */
+struct ProbeStatistics {
+    double raLevel;
+    double quality;
+    double wallSeconds;
+    double cpuSeconds;
+    unsigned int nofOuterIterations;
+    std::vector<FixpointRoundStatistics> rounds;
+    std::vector<ValueIterationStatistics> finalValueIterations; // Towards the winning goal states found
+    ProbeStatistics() : raLevel(0.0), quality(0.0), wallSeconds(0.0), cpuSeconds(0.0), nofOuterIterations(0) {}
+};
+
+/**
+ * @brief The statistics of a run of RAMPS, which can be written as a JSON report.
+ */
+struct PerformanceStatistics {
+    struct Phase {
+        std::string name;
+        double wallSeconds;
+        double cpuSeconds;
+    };
+    std::string model;
+    std::vector<Phase> phases;
+    std::vector<ProbeStatistics> probes;
+    void addPhase(const std::string &name, const StopWatch &stopWatch);
+    void writeJSON(const std::string &filename) const;
+};
+
+#endif
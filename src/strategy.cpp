@@ -0,0 +1,263 @@
+#include "mdp.hpp"
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include <set>
+#include <map>
+#include <cstring>
+
+//=====================================================
+// Strategies
+//
+// The entries of a strategy are stored in flat arrays,
+// so that building a strategy does not allocate memory
+// per entry, and the entries can be written without
+// any lookups. The text writer formats the numbers
+// itself into a large buffer, as writing them with
+// operator<< one by one is much slower for strategies
+// with millions of entries.
+//=====================================================
+
+namespace {
+
+/**
+ * @brief Writes unsigned integers and short strings to an output stream through a large buffer
+ */
+class BufferedTextWriter {
+private:
+    static const size_t bufferSize = 1 << 20;
+    std::ostream &output;
+    std::vector<char> buffer;
+    size_t position;
+public:
+    BufferedTextWriter(std::ostream &_output) : output(_output), buffer(bufferSize), position(0) {}
+    ~BufferedTextWriter() { flush(); }
+    void flush() {
+        output.write(buffer.data(),position);
+        position = 0;
+    }
+    void write(unsigned int value) {
+        if (position+16>bufferSize) flush();
+        char digits[16];
+        unsigned int nofDigits = 0;
+        do {
+            digits[nofDigits++] = '0'+(value % 10);
+            value /= 10;
+        } while (value!=0);
+        while (nofDigits>0) buffer[position++] = digits[--nofDigits];
+    }
+    void write(const char *text) {
+        const size_t length = strlen(text);
+        if (position+length>bufferSize) flush();
+        memcpy(buffer.data()+position,text,length);
+        position += length;
+    }
+};
+
+}
+
+/**
+ * @brief Starts a new entry. Its memory updates have to be added afterwards, followed by a call to "finishEntry".
+ * @param state The product state
+ * @param dataState The data state
+ * @param action The chosen action (as number of the choice of the state)
+ */
+void Strategy::addEntry(unsigned int state, unsigned int dataState, unsigned int action) {
+    entryStates.push_back(state);
+    entryDataStates.push_back(dataState);
+    entryActions.push_back(action);
+    if ((dataState==0) && (state<statesWithInitialDataEntry.size())) statesWithInitialDataEntry[state] = true;
+}
+
+/**
+ * @brief Finishes the entry started last. Its memory updates are sorted by state, and for every state, only the
+ *        last memory update is kept.
+ */
+void Strategy::finishEntry() {
+    const unsigned int begin = updateOffsets.back();
+    const unsigned int end = updateStates.size();
+    bool sorted = true;
+    for (unsigned int k=begin+1;(k<end) && sorted;k++) sorted = updateStates[k-1]<updateStates[k];
+    if (sorted) {
+        updateOffsets.push_back(end);
+        return;
+    }
+    std::vector<std::pair<unsigned int,unsigned int> > updates;
+    updates.reserve(end-begin);
+    for (unsigned int k=begin;k<end;k++) updates.push_back(std::make_pair(updateStates[k],updateDataStates[k]));
+    std::stable_sort(updates.begin(),updates.end(),[](const std::pair<unsigned int,unsigned int> &a, const std::pair<unsigned int,unsigned int> &b) {
+        return a.first<b.first;
+    });
+    unsigned int position = begin;
+    for (unsigned int k=0;k<updates.size();k++) {
+        if ((k+1<updates.size()) && (updates[k+1].first==updates[k].first)) continue;
+        updateStates[position] = updates[k].first;
+        updateDataStates[position] = updates[k].second;
+        position++;
+    }
+    updateStates.resize(position);
+    updateDataStates.resize(position);
+    updateOffsets.push_back(position);
+}
+
+/**
+ * @brief Sorts the entries by data state and state and removes all but the last entry for every pair of them.
+ */
+void Strategy::finalize() {
+    std::vector<unsigned int> order(entryStates.size());
+    std::iota(order.begin(),order.end(),0);
+    std::stable_sort(order.begin(),order.end(),[this](unsigned int a, unsigned int b) {
+        if (entryDataStates[a]!=entryDataStates[b]) return entryDataStates[a]<entryDataStates[b];
+        return entryStates[a]<entryStates[b];
+    });
+
+    Strategy sorted;
+    for (unsigned int i=0;i<order.size();i++) {
+        const unsigned int entry = order[i];
+        if ((i+1<order.size()) && (entryStates[order[i+1]]==entryStates[entry]) && (entryDataStates[order[i+1]]==entryDataStates[entry])) continue;
+        sorted.entryStates.push_back(entryStates[entry]);
+        sorted.entryDataStates.push_back(entryDataStates[entry]);
+        sorted.entryActions.push_back(entryActions[entry]);
+        sorted.updateStates.insert(sorted.updateStates.end(),updateStates.begin()+updateOffsets[entry],updateStates.begin()+updateOffsets[entry+1]);
+        sorted.updateDataStates.insert(sorted.updateDataStates.end(),updateDataStates.begin()+updateOffsets[entry],updateDataStates.begin()+updateOffsets[entry+1]);
+        sorted.updateOffsets.push_back(sorted.updateStates.size());
+    }
+    *this = std::move(sorted);
+}
+
+/**
+ * @brief Searches for the entry of a state and data state. Only works after "finalize" has been called.
+ * @return The number of the entry, or (unsigned int)-1 if there is none
+ */
+unsigned int Strategy::findEntry(unsigned int state, unsigned int dataState) const {
+    unsigned int low = 0;
+    unsigned int high = entryStates.size();
+    while (low<high) {
+        const unsigned int mid = low+(high-low)/2;
+        if ((entryDataStates[mid]<dataState) || ((entryDataStates[mid]==dataState) && (entryStates[mid]<state))) {
+            low = mid+1;
+        } else {
+            high = mid;
+        }
+    }
+    if ((low<entryStates.size()) && (entryStates[low]==state) && (entryDataStates[low]==dataState)) return low;
+    return (unsigned int)-1;
+}
+
+/**
+ * @brief Writes the strategy in the text format of RAMPS: the number of entries, followed by one line
+ *        "<state> <data state> <MDP state> <action>" for every entry, each followed by one line
+ *        "-> <MDP state> <state> <data state>" per memory update.
+ * @param output The stream to write to
+ * @param mdpStates The MDP state of every state of the strategy
+ */
+void Strategy::writeText(std::ostream &output, const std::vector<unsigned int> &mdpStates) const {
+    BufferedTextWriter writer(output);
+    writer.write(nofEntries());
+    writer.write("\n");
+    for (unsigned int i=0;i<nofEntries();i++) {
+        writer.write(entryStates[i]);
+        writer.write(" ");
+        writer.write(entryDataStates[i]);
+        writer.write(" ");
+        writer.write(mdpStates.at(entryStates[i]));
+        writer.write(" ");
+        writer.write(entryActions[i]);
+        writer.write("\n");
+        for (unsigned int k=updateOffsets[i];k<updateOffsets[i+1];k++) {
+            writer.write("-> ");
+            writer.write(mdpStates.at(updateStates[k]));
+            writer.write(" ");
+            writer.write(updateStates[k]);
+            writer.write(" ");
+            writer.write(updateDataStates[k]);
+            writer.write("\n");
+        }
+    }
+}
+
+/**
+ * @brief Prints the policy to stdout, using the states of the product as the states of the policy.
+ */
+void ParityMDP::printPolicy(const Strategy &policy) const {
+    policy.writeText(std::cout,toNonParityMDPMapper);
+}
+
+/**
+ * @brief Writes the policy to a binary strategy file, using the states of the product as the states of the policy.
+ */
+void ParityMDP::writeBinaryPolicy(const Strategy &policy, std::string filename) const {
+    policy.writeBinaryFile(filename,toNonParityMDPMapper);
+}
+
+/**
+ * @brief Maps a policy that has been computed for the product of a bisimulation quotient of an MDP and the parity
+ *        automaton back to the original MDP. The states of the resulting policy are pairs of an original MDP state
+ *        and a product state, numbered in the order in which they are reached from the initial state (which gets the
+ *        number 0). Only the reachable part of the policy is mapped.
+ * @param policy The policy for this parity MDP
+ * @param originalMDP The MDP before minimization
+ * @param mapping The relation between the original MDP and the quotient from which this parity MDP has been built
+ * @param mdpStates Is set to the original MDP state of every state of the resulting policy
+ * @return The mapped policy
+ */
+Strategy ParityMDP::mapPolicyToOriginalMDP(const Strategy &policy, const MDP &originalMDP, const BisimulationQuotientMapping &mapping, std::vector<unsigned int> &mdpStates) const {
+    std::map<std::pair<unsigned int,unsigned int>,unsigned int> outputStates;
+    mdpStates.clear();
+    auto outputState = [&outputStates,&mdpStates](unsigned int mdpState, unsigned int productState) {
+        auto inserted = outputStates.insert(std::make_pair(std::make_pair(mdpState,productState),(unsigned int)outputStates.size()));
+        if (inserted.second) mdpStates.push_back(mdpState);
+        return inserted.first->second;
+    };
+
+    // Breadth-first search over the (original MDP state, product state, data state) triples
+    struct PolicyState {
+        unsigned int mdpState;
+        unsigned int productState;
+        unsigned int dataState;
+    };
+    std::vector<PolicyState> todo;
+    std::set<std::pair<unsigned int,unsigned int> > done;
+    if (originalMDP.initialState!=(unsigned int)-1) {
+        todo.push_back(PolicyState{originalMDP.initialState,initialState,0});
+        done.insert(std::make_pair(outputState(originalMDP.initialState,initialState),0));
+    }
+    Strategy mapped;
+    const TransitionMatrix &originalTransitions = originalMDP.transitions;
+    std::vector<std::pair<unsigned int,unsigned int> > successors;
+    for (unsigned int t=0;t<todo.size();t++) {
+        const PolicyState current = todo[t];
+        const unsigned int entry = policy.findEntry(current.productState,current.dataState);
+        if (entry==(unsigned int)-1) continue;
+
+        // Find the original choice that corresponds to the chosen choice of the quotient
+        unsigned int action = 0;
+        while ((action<originalTransitions.nofChoices(current.mdpState)) && (mapping.quotientChoices[originalTransitions.choiceBegin(current.mdpState)+action]!=policy.action(entry))) action++;
+        if (action==originalTransitions.nofChoices(current.mdpState)) throw "Error: Internal error - the bisimulation quotient does not match the original MDP.";
+        mapped.addEntry(outputState(current.mdpState,current.productState),current.dataState,action);
+
+        // The memory updates by quotient state. There is at most one per quotient state, as the parity automaton is
+        // deterministic.
+        successors.clear();
+        for (unsigned int k=policy.updateBegin(entry);k<policy.updateEnd(entry);k++) {
+            successors.push_back(std::make_pair(toNonParityMDPMapper.at(policy.updateState(k)),k));
+        }
+        std::sort(successors.begin(),successors.end());
+        const unsigned int choice = originalTransitions.choiceBegin(current.mdpState)+action;
+        for (unsigned int k=originalTransitions.edgeBegin(choice);k<originalTransitions.edgeEnd(choice);k++) {
+            const unsigned int target = originalTransitions.targets[k];
+            auto successor = std::lower_bound(successors.begin(),successors.end(),std::make_pair(mapping.quotientStates[target],0u));
+            if ((successor==successors.end()) || (successor->first!=mapping.quotientStates[target])) continue;
+            const unsigned int productState = policy.updateState(successor->second);
+            const unsigned int dataState = policy.updateDataState(successor->second);
+            const unsigned int targetOutputState = outputState(target,productState);
+            mapped.addMemoryUpdate(targetOutputState,dataState);
+            if (done.insert(std::make_pair(targetOutputState,dataState)).second) {
+                todo.push_back(PolicyState{target,productState,dataState});
+            }
+        }
+        mapped.finishEntry();
+    }
+    mapped.finalize();
+    return mapped;
+}
@@ -0,0 +1,550 @@
+#ifndef __VALUE_ITERATION_HPP____
+#define __VALUE_ITERATION_HPP____
+
+#include "mdp.hpp"
+#include "graphAnalysis.hpp"
+#include "singlePrecisionValueIteration.hpp"
+#include "statistics.hpp"
+#include "distributedValueIteration.hpp"
+#include <vector>
+#include <map>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+/**
+ * @brief Computes the maximal value of a state over all of its choices (a "Bellman backup").
+ * @param transitions The transition relation
+ * @param state The state for which the value is to be computed
+ * @param lookup A function that yields the current value of a successor state
+ * @param bestDirection Is set to the choice with the highest value. Is not changed if no choice has a value > 0.0
+ * @return The maximal value
+ */
+template<class Transitions, class ValueLookup> inline double bellmanBackup(const Transitions &transitions, unsigned int state, const ValueLookup &lookup, unsigned int &bestDirection) {
+    double bestValue = 0.0;
+    for (unsigned int j=0;j<transitions.nofChoices(state);j++) {
+        const unsigned int choice = transitions.choiceBegin(state)+j;
+        double newValue = 0.0;
+        for (unsigned int k=transitions.edgeBegin(choice);k<transitions.edgeEnd(choice);k++) {
+            newValue += transitions.probability(k)*lookup(transitions.target(state,k));
+        }
+        if (newValue > bestValue) {
+            bestValue = newValue;
+            bestDirection = j;
+        }
+    }
+    return bestValue;
+}
+
+/**
+ * @brief Optional additional inputs (and outputs) of value iteration that can help to solve a problem faster.
+ */
+struct ValueIterationHints {
+    // For the TOPOLOGICAL method: An SCC decomposition of the MDP that is valid for the given fixed values
+    // (see "computeSCCDecomposition"). If it is NULL, it is computed by value iteration.
+    const SCCDecomposition *sccDecomposition;
+
+    // For the qualitative precomputation and interval iteration: The predecessor relation of the MDP (see
+    // "computePredecessorRelation"). If it is NULL, it is computed by value iteration.
+    const PredecessorRelation *predecessors;
+
+    // Values (and policy choices) to start from for the states that are not fixed, e.g., the result of an earlier
+    // value iteration call for a similar problem. If NULL, value iteration starts from all-zero values.
+    const std::vector<std::pair<double,unsigned int> > *initialValues;
+
+    // Whether the initial values are upper bounds of the values (rather than lower bounds). In this case, values
+    // may also decrease during the iteration. Starting from above only leads to the correct values if every policy
+    // eventually leaves the states that value iteration updates. If some of them form an end component, value
+    // iteration hence ignores the initial values and starts from 0. With interval iteration, the initial values are
+    // instead used as starting point for the upper bounds, and the lower bounds start from 0.
+    bool initialValuesAreUpperBounds;
+
+    // For interval iteration: Upper bounds to start from (if not NULL and not empty). Is set to the final upper
+    // bounds afterwards.
+    std::vector<double> *upperBounds;
+
+    // For interval iteration: If not NULL, the iteration stops as soon as for each of these states, it is known
+    // whether its value is below the threshold or not.
+    const std::vector<unsigned int> *thresholdStates;
+    double threshold;
+
+    // If not NULL, is set to the statistics of the call
+    ValueIterationStatistics *statistics;
+
+    ValueIterationHints() : sccDecomposition(NULL), predecessors(NULL), initialValues(NULL), initialValuesAreUpperBounds(false), upperBounds(NULL), thresholdStates(NULL), threshold(0.0), statistics(NULL) {}
+};
+
+/**
+ * @brief Prepares value iteration for an MDP that differs from a previous version in a few states only. The states
+ *        that cannot reach these states (without passing through states with fixed values) have the same values as
+ *        in the previous version, so their values are fixed to the previous ones. Value iteration then only updates
+ *        the remaining states. Afterwards, the previous results (including the policy) are to be taken over for the
+ *        states returned, as value iteration only recomputes the policy for them from the values, which does not
+ *        make progress towards the goal states in SCCs of states with the value 1.
+ * @param predecessors The predecessor relation of the MDP (see "computePredecessorRelation")
+ * @param previousValues The result of value iteration for the previous version (in the state numbers of the MDP)
+ * @param differingStates The states whose transitions or fixed values differ from the previous version
+ * @param fixedValues The fixed values of the problem, to which the values of the unaffected states are added
+ * @return The states whose values have been fixed
+ */
+inline std::vector<unsigned int> fixValuesOfUnaffectedStates(const PredecessorRelation &predecessors, const std::vector<std::pair<double,unsigned int> > &previousValues, const std::vector<char> &differingStates, FixedValues &fixedValues) {
+    const unsigned int nofStates = fixedValues.nofStates();
+    std::vector<char> fixedStates(nofStates);
+    for (unsigned int i=0;i<nofStates;i++) fixedStates[i] = fixedValues.isFixed(i);
+    const std::vector<char> affectedStates = computeStatesThatCanReach(predecessors,differingStates,fixedStates);
+    std::vector<unsigned int> unaffectedStates;
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (!fixedStates[i] && !affectedStates[i]) {
+            fixedValues.set(i,previousValues[i].first);
+            unaffectedStates.push_back(i);
+        }
+    }
+    return unaffectedStates;
+}
+
+/**
+ * @brief The Value iteration function for reachability MDPs. There are two variants of this function.
+ *        It works on any transition relation that offers the interface of a "TransitionMatrix", so that it
+ *        can also be applied to views that compute the transitions on-the-fly.
+ *
+ *        With the UNSYNCHRONIZED method, all threads update a shared value array in place without
+ *        synchronization, which may occasionally lead to slightly too early termination. With the
+ *        BLOCK_GAUSS_SEIDEL method, the states are split into blocks of fixed size. Within a block, values
+ *        are updated in place (Gauss-Seidel style), whereas values from other blocks are taken from the
+ *        end of the previous sweep. As the blocks do not depend on the number of threads, the results are
+ *        the same for any number of threads, and the termination test is exact. With the TOPOLOGICAL method,
+ *        the strongly connected components (SCCs) of the MDP are processed in reverse topological order, and
+ *        value iteration is only performed within each SCC until it converges. States that are not on a cycle
+ *        are then updated only once. In this case, the sum of the updates of an SCC in one step needs to fall
+ *        below the share of epsilon that corresponds to the share of the states that are in the SCC.
+ *
+ *        With interval iteration, upper bounds on the values are computed along with the values (which are
+ *        lower bounds). The iteration then also stops when the sum of the differences between the bounds
+ *        is below epsilon, or when for all threshold states (see ValueIterationHints), it is known on which
+ *        side of the threshold their values are. The upper bounds only converge if every policy eventually
+ *        leaves the touchable states. In an end component, they never decrease from their initial values
+ *        (usually 1), so that the gap test and the threshold decisions do not apply, and the iteration stops by
+ *        the epsilon test on the value changes only. Threshold states are not supported for the TOPOLOGICAL
+ *        method.
+ *
+ *        With the DISTRIBUTED method (only if RAMPS is built with MPI), this function is called by the root MPI
+ *        process. The states are split into one contiguous slice per process, and every other process gets the
+ *        transitions of its slice only (see "distributeValueIterationProblem"). Every process updates the states
+ *        in its slice, in place as with the UNSYNCHRONIZED method. Values from other slices are taken from the end
+ *        of the previous sweep, so after every sweep, the processes exchange the values that other slices depend
+ *        on, and the sum of the changes over all slices is used for the termination test. At the end, the root
+ *        process collects the values of all slices. Interval iteration is not supported by this method.
+ * @param transitions The transition relation
+ * @param fixedValues The values of the MDP states that are goals or non-goals (for all states of the transition relation)
+ * @param settings The cutoff value for value iteration, the method, whether interval iteration is used, and whether
+ *        the strategy should be computed eagerly, i.e., at every step of the value iteration process. The latter is necessary
+ *        if we have MDPs with strongly connected components of states that have all the same value, as no strategy reconstruction
+ *        can be made from their values
+ * @param hints Optional additional inputs and outputs - see ValueIterationHints
+ * @return The state values and the policy
+ */
+template<class Transitions> std::vector<std::pair<double,unsigned int> > performValueIteration(const Transitions &transitions, const FixedValues &fixedValues, const ValueIterationSettings &settings, const ValueIterationHints &hints = ValueIterationHints()) {
+
+    const StopWatch stopWatch;
+    unsigned int nofSweeps = 0;
+    double finalResidual = 0.0;
+    const unsigned int nofStates = transitions.nofStates();
+    const bool computePolicyEagerly = settings.computePolicyEagerly;
+    const bool intervalIteration = settings.intervalIteration;
+    const std::vector<std::pair<double,unsigned int> > *initialValues = hints.initialValues;
+    bool initialValuesAreUpperBounds = hints.initialValuesAreUpperBounds && !intervalIteration;
+    const bool initialValuesForUpperBounds = hints.initialValuesAreUpperBounds && intervalIteration;
+#ifdef USE_MPI
+    if ((settings.method==ValueIterationSettings::DISTRIBUTED) && intervalIteration) throw "Error: Interval iteration is not supported by the distributed value iteration method.";
+#else
+    if (settings.method==ValueIterationSettings::DISTRIBUTED) throw "Error: The distributed value iteration method needs RAMPS to be built with MPI.";
+#endif
+
+    // Initialize result
+    std::vector<bool> touchable(nofStates);
+    double *newValues = new double[nofStates];
+    unsigned int *currentPolicy = computePolicyEagerly?(new unsigned int[nofStates]):NULL;
+    double *upperValues = intervalIteration?(new double[nofStates]):NULL;
+
+    assert((initialValues==NULL) || (initialValues->size()==nofStates));
+    assert(fixedValues.nofStates()==nofStates);
+    #pragma omp parallel for schedule(static)
+    for (unsigned int i=0;i<nofStates;i++) {
+        newValues[i] = ((initialValues==NULL) || initialValuesForUpperBounds)?0.0:std::min(1.0,std::max(0.0,(*initialValues)[i].first));
+        touchable[i] = true;
+        if (computePolicyEagerly) currentPolicy[i] = (initialValues==NULL)?0:(*initialValues)[i].second;
+        if (intervalIteration) {
+            upperValues[i] = 1.0;
+            if ((hints.upperBounds!=NULL) && (hints.upperBounds->size()==nofStates)) upperValues[i] = std::min(upperValues[i],(*hints.upperBounds)[i]);
+            if (initialValuesForUpperBounds && (initialValues!=NULL)) upperValues[i] = std::min(upperValues[i],(*initialValues)[i].first);
+            upperValues[i] = std::max(upperValues[i],newValues[i]);
+        }
+    }
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (!fixedValues.isFixed(i)) continue;
+        newValues[i] = fixedValues.value(i);
+        touchable[i] = false;
+        if (intervalIteration) upperValues[i] = fixedValues.value(i);
+    }
+
+    // Qualitative precomputation: States that cannot reach a fixed state with a non-zero value have the value 0
+    // ("Prob0"), and states that can reach the fixed states with value 1 with probability 1 have the value 1
+    // ("Prob1"). They are then not touched by value iteration. For the latter states, the policy reaching the
+    // fixed states is stored. With interval iteration, Prob0 is always computed, as the upper bounds would
+    // otherwise never decrease for these states.
+    std::vector<bool> qualitativelySolved(nofStates,false);
+    std::vector<unsigned int> qualitativePolicy;
+    PredecessorRelation localPredecessors;
+    const PredecessorRelation *predecessors = hints.predecessors;
+    auto computePredecessorsIfNeeded = [&]() {
+        if (predecessors==NULL) {
+            localPredecessors = computePredecessorRelation(transitions);
+            predecessors = &localPredecessors;
+        }
+    };
+    if (intervalIteration || settings.qualitativePrecomputation) {
+        std::vector<char> fixedStates(nofStates,0);
+        std::vector<char> positiveFixedStates(nofStates,0);
+        std::vector<char> oneFixedStates(nofStates,0);
+        #pragma omp parallel for schedule(static)
+        for (unsigned int i=0;i<nofStates;i++) {
+            if (!fixedValues.isFixed(i)) continue;
+            fixedStates[i] = 1;
+            positiveFixedStates[i] = fixedValues.value(i)>0.0;
+            oneFixedStates[i] = fixedValues.value(i)>=1.0;
+        }
+        computePredecessorsIfNeeded();
+        std::vector<char> prob0Complement = computeStatesThatCanReach(*predecessors,positiveFixedStates,fixedStates);
+        std::vector<char> prob1;
+        if (settings.qualitativePrecomputation) {
+            prob1 = computeStatesThatReachWithProbabilityOne(*predecessors,oneFixedStates,fixedStates,computeStatesThatCanReach(*predecessors,oneFixedStates,fixedStates),qualitativePolicy);
+        }
+        qualitativePolicy.resize(nofStates,0);
+        for (unsigned int i=0;i<nofStates;i++) {
+            if (!touchable[i]) continue;
+            if (!prob0Complement[i]) {
+                newValues[i] = 0.0;
+                qualitativePolicy[i] = 0;
+            } else if (settings.qualitativePrecomputation && prob1[i]) {
+                newValues[i] = 1.0;
+            } else {
+                continue;
+            }
+            if (intervalIteration) upperValues[i] = newValues[i];
+            if (computePolicyEagerly) currentPolicy[i] = qualitativePolicy[i];
+            touchable[i] = false;
+            qualitativelySolved[i] = true;
+        }
+    }
+
+    // Starting from above only converges to the least fixpoint if no policy can stay in the touchable states
+    // forever. In an end component, the values would otherwise stay at their initial values, so value iteration
+    // then starts from zero instead.
+    if (initialValuesAreUpperBounds) {
+        computePredecessorsIfNeeded();
+        std::vector<char> touchableStates(nofStates);
+        for (unsigned int i=0;i<nofStates;i++) touchableStates[i] = touchable[i];
+        if (containsEndComponent(*predecessors,touchableStates)) {
+            initialValuesAreUpperBounds = false;
+            initialValues = NULL;
+            for (unsigned int i=0;i<nofStates;i++) {
+                if (touchable[i]) newValues[i] = 0.0;
+            }
+        }
+    }
+
+    // Single precision warm start: If value iteration starts from zero, lower bounds are first computed with
+    // single precision values, which halves the memory traffic per edge and allows to vectorize the dot
+    // products. Value iteration with double precision then continues from there.
+    if (settings.singlePrecision && ((initialValues==NULL) || initialValuesForUpperBounds)) {
+        SinglePrecisionTransitions singlePrecisionTransitions = buildSinglePrecisionTransitions(transitions,touchable);
+        if (canUseSinglePrecisionValueIteration(singlePrecisionTransitions)) {
+            std::vector<float> singlePrecisionValues(nofStates);
+            std::vector<unsigned int> singlePrecisionPolicy(nofStates,0);
+            for (unsigned int i=0;i<nofStates;i++) {
+                singlePrecisionValues[i] = roundDownToFloat(newValues[i]);
+                if (computePolicyEagerly) singlePrecisionPolicy[i] = currentPolicy[i];
+            }
+            const unsigned int nofSinglePrecisionSweeps = performSinglePrecisionValueIteration(singlePrecisionTransitions,singlePrecisionValues,singlePrecisionPolicy,settings.epsilon);
+            if (hints.statistics!=NULL) hints.statistics->nofSinglePrecisionSweeps = nofSinglePrecisionSweeps;
+            for (unsigned int i : singlePrecisionTransitions.states) {
+                newValues[i] = singlePrecisionValues[i];
+                if (computePolicyEagerly) currentPolicy[i] = singlePrecisionPolicy[i];
+                if (intervalIteration) upperValues[i] = std::max(upperValues[i],newValues[i]);
+            }
+        }
+    }
+
+    // Updates the value of state i from a new best value and returns the change.
+    // With eager policy computation, the best direction is stored and values
+    // only move away from the initial bounds. Otherwise, the direction is computed
+    // at the end.
+    auto updateState = [&newValues,&currentPolicy,computePolicyEagerly,initialValuesAreUpperBounds](unsigned int i, double bestValue, unsigned int bestDirection) -> double {
+        if (computePolicyEagerly) {
+            if (initialValuesAreUpperBounds?(bestValue < newValues[i]):(bestValue > newValues[i])) {
+                double change = std::abs(bestValue - newValues[i]);
+                newValues[i] = bestValue;
+                if (bestDirection!=(unsigned int)-1) currentPolicy[i] = bestDirection;
+                return change;
+            }
+            return 0.0;
+        } else {
+            double change = std::abs(bestValue - newValues[i]);
+            newValues[i] = std::nextafter(bestValue,0.0);
+            return change;
+        }
+    };
+
+    // Interval iteration: Updates the upper bound of state i. Rounding is performed upwards,
+    // and upper bounds never increase.
+    auto updateUpperBound = [&upperValues](unsigned int i, double bestUpperValue) {
+        upperValues[i] = std::min(upperValues[i],std::nextafter(bestUpperValue,2.0));
+    };
+
+    // Interval iteration: Checks if for all threshold states, it is known on which side of the threshold
+    // their values are. For states with fixed values, the value computed at the end of this function is used.
+    auto thresholdStatesDecided = [&]() {
+        if (hints.thresholdStates==NULL) return false;
+        auto lowerLookup = [newValues](unsigned int target) { return newValues[target]; };
+        auto upperLookup = [upperValues](unsigned int target) { return upperValues[target]; };
+        for (unsigned int state : *hints.thresholdStates) {
+            unsigned int dir = 0;
+            const bool isFixed = !touchable[state] && !qualitativelySolved[state];
+            double lower = !isFixed?newValues[state]:std::nextafter(bellmanBackup(transitions,state,lowerLookup,dir),0.0);
+            if (lower>=hints.threshold) continue;
+            double upper = !isFixed?upperValues[state]:bellmanBackup(transitions,state,upperLookup,dir);
+            if (upper<hints.threshold) continue;
+            return false;
+        }
+        return true;
+    };
+
+    // Termination check after an iteration step. With interval iteration, the sum of the differences
+    // between the upper bounds and the values bounds all future changes of the values.
+    auto isTerminated = [&](double diff, double gapSum, double currentEpsilon, bool checkThresholdStates) {
+        if (diff <= currentEpsilon) return true;
+        if (!intervalIteration) return false;
+        if (gapSum <= currentEpsilon) return true;
+        return checkThresholdStates && thresholdStatesDecided();
+    };
+
+    // Perform iteration
+    if (settings.method==ValueIterationSettings::BLOCK_GAUSS_SEIDEL) {
+
+        //=========================================
+        // Deterministic block Gauss-Seidel
+        //=========================================
+        const unsigned int blockSize = 16384;
+        const unsigned int nofBlocks = (nofStates+blockSize-1)/blockSize;
+        double *previousValues = new double[nofStates];
+        double *previousUpperValues = intervalIteration?(new double[nofStates]):NULL;
+        std::vector<double> blockDiffs(nofBlocks);
+        std::vector<double> blockGapSums(nofBlocks);
+        bool terminated = intervalIteration && thresholdStatesDecided();
+        while (!terminated) {
+            memcpy(previousValues,newValues,sizeof(double)*nofStates);
+            if (intervalIteration) memcpy(previousUpperValues,upperValues,sizeof(double)*nofStates);
+
+            #pragma omp parallel for schedule(dynamic)
+            for (unsigned int b=0;b<nofBlocks;b++) {
+                const unsigned int blockStart = b*blockSize;
+                const unsigned int blockEnd = std::min(nofStates,blockStart+blockSize);
+                auto lookup = [newValues,previousValues,blockStart,blockEnd](unsigned int target) {
+                    return ((target>=blockStart) && (target<blockEnd))?newValues[target]:previousValues[target];
+                };
+                auto upperLookup = [upperValues,previousUpperValues,blockStart,blockEnd](unsigned int target) {
+                    return ((target>=blockStart) && (target<blockEnd))?upperValues[target]:previousUpperValues[target];
+                };
+                double blockDiff = 0.0;
+                double blockGapSum = 0.0;
+                for (unsigned int i=blockStart;i<blockEnd;i++) {
+                    if (touchable[i]) {
+                        unsigned int bestDirection = (unsigned int)-1;
+                        double bestValue = bellmanBackup(transitions,i,lookup,bestDirection);
+                        blockDiff += updateState(i,bestValue,bestDirection);
+                        if (intervalIteration) {
+                            updateUpperBound(i,bellmanBackup(transitions,i,upperLookup,bestDirection));
+                            blockGapSum += upperValues[i]-newValues[i];
+                        }
+                    }
+                }
+                blockDiffs[b] = blockDiff;
+                blockGapSums[b] = blockGapSum;
+            }
+
+            // Sum up in a fixed order so that the result does not depend on the number of threads
+            double diff = 0.0;
+            double gapSum = 0.0;
+            for (unsigned int b=0;b<nofBlocks;b++) {
+                diff += blockDiffs[b];
+                gapSum += blockGapSums[b];
+            }
+            nofSweeps++;
+            finalResidual = diff;
+            terminated = isTerminated(diff,gapSum,settings.epsilon,true);
+        }
+        delete[] previousValues;
+        delete[] previousUpperValues;
+
+    } else if (settings.method==ValueIterationSettings::TOPOLOGICAL) {
+
+        //=========================================
+        // SCC-wise value iteration in reverse
+        // topological order
+        //=========================================
+        const SCCDecomposition *sccDecomposition = hints.sccDecomposition;
+        SCCDecomposition localDecomposition;
+        if (sccDecomposition==NULL) {
+            std::vector<bool> fixed(nofStates);
+            for (unsigned int i=0;i<nofStates;i++) fixed[i] = !touchable[i];
+            localDecomposition = computeSCCDecomposition(transitions,fixed);
+            sccDecomposition = &localDecomposition;
+        }
+        assert(sccDecomposition->sccStates.size()==nofStates);
+
+        const unsigned int minimalSCCSizeForMultiThreading = 4096;
+        const unsigned int *sccStates = sccDecomposition->sccStates.data();
+        auto lookup = [newValues](unsigned int target) { return newValues[target]; };
+        auto upperLookup = [upperValues](unsigned int target) { return upperValues[target]; };
+        for (unsigned int scc=0;scc<sccDecomposition->nofSCCs();scc++) {
+            const unsigned int sccBegin = sccDecomposition->sccOffsets[scc];
+            const unsigned int sccEnd = sccDecomposition->sccOffsets[scc+1];
+            if (sccDecomposition->trivial[scc]) {
+                // All successors have their final values already
+                const unsigned int i = sccStates[sccBegin];
+                if (touchable[i]) {
+                    unsigned int bestDirection = (unsigned int)-1;
+                    double bestValue = bellmanBackup(transitions,i,lookup,bestDirection);
+                    updateState(i,bestValue,bestDirection);
+                    if (intervalIteration) updateUpperBound(i,bellmanBackup(transitions,i,upperLookup,bestDirection));
+                }
+            } else {
+                const double sccEpsilon = settings.epsilon*(sccEnd-sccBegin)/nofStates;
+                bool terminated = false;
+                double sccDiff = 0.0;
+                while (!terminated) {
+                    sccDiff = 0.0;
+                    double sccGapSum = 0.0;
+                    #pragma omp parallel for reduction (+:sccDiff,sccGapSum) if (sccEnd-sccBegin>=minimalSCCSizeForMultiThreading)
+                    for (unsigned int j=sccBegin;j<sccEnd;j++) {
+                        const unsigned int i = sccStates[j];
+                        if (touchable[i]) {
+                            unsigned int bestDirection = (unsigned int)-1;
+                            double bestValue = bellmanBackup(transitions,i,lookup,bestDirection);
+                            sccDiff += updateState(i,bestValue,bestDirection);
+                            if (intervalIteration) {
+                                updateUpperBound(i,bellmanBackup(transitions,i,upperLookup,bestDirection));
+                                sccGapSum += upperValues[i]-newValues[i];
+                            }
+                        }
+                    }
+                    nofSweeps++;
+                    terminated = isTerminated(sccDiff,sccGapSum,sccEpsilon,false);
+                }
+                finalResidual += sccDiff;
+            }
+        }
+
+    } else if (settings.method==ValueIterationSettings::DISTRIBUTED) {
+
+        //=========================================
+        // Slices of the states on MPI processes
+        //=========================================
+#ifdef USE_MPI
+        DistributedValueIterationParameters parameters;
+        parameters.epsilon = settings.epsilon;
+        parameters.computePolicyEagerly = computePolicyEagerly;
+        parameters.initialValuesAreUpperBounds = initialValuesAreUpperBounds;
+        startDistributedValueIteration(parameters);
+        std::vector<unsigned int> sliceBegins;
+        DistributedSlice slice = distributeValueIterationProblem(transitions,touchable,newValues,currentPolicy,sliceBegins);
+        nofSweeps = solveDistributedSlice(slice,parameters,finalResidual);
+        gatherSliceResults(slice,parameters,sliceBegins,newValues,currentPolicy);
+#endif
+
+    } else {
+
+        //=========================================
+        // Unsynchronized in-place updates
+        //=========================================
+        auto lookup = [newValues](unsigned int target) { return newValues[target]; };
+        auto upperLookup = [upperValues](unsigned int target) { return upperValues[target]; };
+        bool terminated = intervalIteration && thresholdStatesDecided();
+        while (!terminated) {
+
+            double diff = 0.0;
+            double gapSum = 0.0;
+
+            #pragma omp parallel for reduction (+:diff,gapSum)
+            for (unsigned int i=0;i<nofStates;i++) {
+                if (touchable[i]) {
+                    unsigned int bestDirection = (unsigned int)-1;
+                    double bestValue = bellmanBackup(transitions,i,lookup,bestDirection);
+                    diff += updateState(i,bestValue,bestDirection);
+                    if (intervalIteration) {
+                        updateUpperBound(i,bellmanBackup(transitions,i,upperLookup,bestDirection));
+                        gapSum += upperValues[i]-newValues[i];
+                    }
+                }
+            }
+            nofSweeps++;
+            finalResidual = diff;
+            terminated = isTerminated(diff,gapSum,settings.epsilon,true);
+        }
+    }
+
+    // Now build the value+action result
+    std::vector<std::pair<double,unsigned int> > result(nofStates);
+    if (computePolicyEagerly) {
+        #pragma omp parallel for
+        for (unsigned int i=0;i<nofStates;i++) {
+            result[i] = std::pair<double,unsigned int>(newValues[i],currentPolicy[i]);
+        }
+    } else {
+        auto lookup = [newValues](unsigned int target) { return newValues[target]; };
+        #pragma omp parallel for
+        for (unsigned int i=0;i<nofStates;i++) {
+            if (touchable[i]) {
+                unsigned int dir = 0;
+                double bestValue = bellmanBackup(transitions,i,lookup,dir);
+                result[i] = std::pair<double,unsigned int>(std::nextafter(bestValue,0.0),dir);
+            }
+        }
+    }
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (qualitativelySolved[i]) result[i] = std::pair<double,unsigned int>(newValues[i],qualitativePolicy[i]);
+    }
+    if (intervalIteration && (hints.upperBounds!=NULL)) {
+        hints.upperBounds->assign(upperValues,upperValues+nofStates);
+    }
+
+    delete[] newValues;
+    delete[] currentPolicy;
+    delete[] upperValues;
+
+    // Now recompute all fixed-probability values
+    for (unsigned int i=0;i<nofStates;i++) {
+        if (!(touchable[i]) && !(qualitativelySolved[i])) {
+            unsigned int dir = 0;
+            auto lookup = [&fixedValues,&result](unsigned int target) {
+                return fixedValues.isFixed(target)?fixedValues.value(target):result[target].first;
+            };
+            double bestValue = bellmanBackup(transitions,i,lookup,dir);
+            result[i] = std::pair<double,unsigned int>(std::nextafter(bestValue,0.0),dir);
+        }
+        assert(result[i].second < transitions.nofChoices(i));
+    }
+
+    if (hints.statistics!=NULL) {
+        hints.statistics->wallSeconds = stopWatch.wallSeconds();
+        hints.statistics->cpuSeconds = stopWatch.cpuSeconds();
+        hints.statistics->nofSweeps = nofSweeps;
+        hints.statistics->finalResidual = finalResidual;
+        hints.statistics->nofTouchableStates = std::count(touchable.begin(),touchable.end(),true);
+        hints.statistics->peakMemoryInKB = getPeakMemoryInKB();
+    }
+    return result;
+}
+
+#endif